@@ -24,7 +24,30 @@ ASceneCaptureSeurat::ASceneCaptureSeurat(const FObjectInitializer& ObjectInitial
 	// Initialize capturing parameters.
 	Resolution = ECaptureResolution::K1024;
 	SamplesPerFace = EPositionSampleCount::K8;
+	CustomSampleCount = 512;
+	SamplePattern = ECaptureSamplePattern::Hammersley;
+	SampleSeed = 0;
 	HeadboxSize = FVector(100, 100, 100);
+	CubeCaptureMode = ECubeCaptureMode::SeparateFaces;
+	ResolutionFalloffLevels = 0;
+	ResolutionFalloffStart = 0.5f;
+	MaxTileResolution = 4096;
+	ExrCompression = ECaptureExrCompression::Zip;
+	DepthPrecision = ECaptureDepthPrecision::Float;
+	DepthEncoding = ECaptureDepthEncoding::Exr;
+	ReadbackBufferCount = 3;
+	ViewsPerTick = 2;
+	CaptureComponentPoolSize = 1;
+	CaptureMemoryBudgetMB = 1024;
+	WriterThreadCount = 4;
+	WriterMemoryBudgetMB = 2048;
+	bCompactManifest = false;
+	bBinaryManifest = false;
+	bPackImages = false;
+	bCullFaces = false;
+	CullMinGeometryFraction = 0.01f;
+	CullMaxParallaxPixels = 0.5f;
+	SkyDepth = 60000.0f;
 	GetCaptureComponent2D()->bCaptureEveryFrame = false;
 	GetCaptureComponent2D()->bCaptureOnMovement = false;
 	PrimaryActorTick.bCanEverTick = true;
@@ -30,6 +30,22 @@ enum class EPositionSampleCount : uint8
 	K64 = 6,
 	K128 = 7,
 	K256 = 8,
+	// Uses Custom Sample Count, which need not be a power of two.
+	Custom = 0,
+};
+
+UENUM()
+enum class ECaptureSamplePattern : uint8
+{
+	Hammersley,
+	Sobol,
+	// Randomized by the sample seed, which avoids the regular structure of the
+	// other patterns in dense headboxes.
+	ScrambledSobol,
+	// Scrambled Sobol with more samples where the scene has more depth edges,
+	// which moving the viewer disoccludes. A low resolution depth pre-pass at
+	// the headbox corners measures them.
+	Adaptive,
 };
 
 UENUM()
@@ -40,6 +56,46 @@ enum class ECaptureResolution : uint8
 	K2048 = 11,
 	K4096 = 12,
 	K1536 = 13,
+	// Rendered in tiles of at most Max Tile Resolution.
+	K8192 = 14,
+	K16384 = 15,
+};
+
+UENUM()
+enum class ECubeCaptureMode : uint8
+{
+	// Rotates the 2D capture component through the six faces of each sample.
+	SeparateFaces,
+	// Renders all six faces of each sample with a single cube capture. Falls
+	// back to separate faces if cube captures don't write depth.
+	SinglePass,
+};
+
+UENUM()
+enum class ECaptureExrCompression : uint8
+{
+	None,
+	Zip,
+	Piz,
+	// Lossy for color; depth is still stored losslessly.
+	Dwaa,
+};
+
+UENUM()
+enum class ECaptureDepthPrecision : uint8
+{
+	Float,
+	Half,
+};
+
+UENUM()
+enum class ECaptureDepthEncoding : uint8
+{
+	// Depth in the alpha channel of each EXR image.
+	Exr,
+	// Depth in a separate file with a lossless codec for depth. Considerably
+	// smaller, but must be decoded back to EXR before Seurat processes it.
+	Lossless UMETA(DisplayName = "Lossless Codec"),
 };
 
 UCLASS(hidecategories = (Collision, Material, Attachment, Actor), MinimalAPI)
@@ -53,6 +109,121 @@ class ASceneCaptureSeurat : public ASceneCapture2D
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, meta = (DisplayName = "Samples Per Face"))
 	EPositionSampleCount SamplesPerFace;
 
+	// Number of headbox samples when Samples Per Face is Custom. Dense sampling
+	// of large headboxes takes proportionally longer to capture.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Custom Sample Count", ClampMin = "1", ClampMax = "65536"))
+	int32 CustomSampleCount;
+
+	// Distribution of the samples in the headbox.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Sample Pattern"))
+	ECaptureSamplePattern SamplePattern;
+
+	// Seed of the Scrambled Sobol and Adaptive patterns. The same seed always gives the same
+	// samples.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Sample Seed", ClampMin = "0"))
+	int32 SampleSeed;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, meta = (DisplayName = "Resolution"))
 	ECaptureResolution Resolution;
+
+	// Number of times the resolution halves towards the headbox corners. Outer
+	// samples add less unique detail than the center, so capturing them at
+	// lower resolution saves rendering, readback and storage.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Resolution Falloff Levels", ClampMin = "0", ClampMax = "4"))
+	int32 ResolutionFalloffLevels;
+
+	// Distance from the headbox center, as a fraction of the distance to the
+	// corners, within which samples keep full resolution.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Resolution Falloff Start", ClampMin = "0.0", ClampMax = "1.0"))
+	float ResolutionFalloffStart;
+
+	// Largest render target a view renders into. Views of higher resolution are
+	// rendered as a grid of tiles, each with the part of the view's projection
+	// it covers, and written to a tiled EXR image one tile at a time. Screen
+	// space effects only see their own tile and may show seams.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Max Tile Resolution", ClampMin = "256", ClampMax = "4096"))
+	int32 MaxTileResolution;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, meta = (DisplayName = "Cube Capture Mode"))
+	ECubeCaptureMode CubeCaptureMode;
+
+	// Compression of the capture images.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, meta = (DisplayName = "EXR Compression"))
+	ECaptureExrCompression ExrCompression;
+
+	// Precision of the depth channel. Color is always stored as half floats.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, meta = (DisplayName = "Depth Precision"))
+	ECaptureDepthPrecision DepthPrecision;
+
+	// How depth is stored. With the lossless codec, depth is always full
+	// precision and the EXR images only hold color.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Depth Encoding"))
+	ECaptureDepthEncoding DepthEncoding;
+
+	// Number of render targets in flight. While one view is copied back to the
+	// CPU, the next view renders into another target.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Readback Buffer Count", ClampMin = "1", ClampMax = "16"))
+	int32 ReadbackBufferCount;
+
+	// Maximum number of views rendered per frame. Higher values finish sooner
+	// at the cost of longer frames while capturing.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Views Per Tick", ClampMin = "1", ClampMax = "64"))
+	int32 ViewsPerTick;
+
+	// Number of capture components that render views in the same frame, each
+	// into its own render target. Most effective with single pass cube capture,
+	// where each component renders a different headbox sample.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Capture Component Pool Size", ClampMin = "1", ClampMax = "16"))
+	int32 CaptureComponentPoolSize;
+
+	// GPU memory all capture render targets together may use. Limits the pool
+	// size and readback buffer count at high resolutions.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Capture Memory Budget (MB)", ClampMin = "64"))
+	int32 CaptureMemoryBudgetMB;
+
+	// Number of threads that encode and write capture images.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Writer Thread Count", ClampMin = "1", ClampMax = "32"))
+	int32 WriterThreadCount;
+
+	// Memory the queue of images waiting to be written may use before capture
+	// waits for the writers.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Writer Memory Budget (MB)", ClampMin = "64"))
+	int32 WriterMemoryBudgetMB;
+
+	// Skips the faces of samples that see too little geometry, such as faces
+	// that only see sky, and faces whose content is too distant to differ from
+	// a nearby captured sample. A low resolution depth pre-pass of every
+	// sample decides, and the manifest lists the culled faces of each sample.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Cull Faces"))
+	bool bCullFaces;
+
+	// Faces with geometry in less than this fraction of their pixels are culled.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Cull Min Geometry Fraction", ClampMin = "0.0", ClampMax = "1.0"))
+	float CullMinGeometryFraction;
+
+	// Faces whose content moves less than this many pixels relative to a
+	// nearby captured sample are culled.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Cull Max Parallax (Pixels)", ClampMin = "0.0"))
+	float CullMaxParallaxPixels;
+
+	// Depth beyond which a pixel counts as sky, in centimeters. Updating a
+	// capture recaptures views that see this far for any change in view.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Sky Depth", ClampMin = "1.0"))
+	float SkyDepth;
+
+	// Writes manifest.json without indentation or line breaks, which keeps
+	// manifests of large captures considerably smaller.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Compact Manifest"))
+	bool bCompactManifest;
+
+	// Also writes manifest.smnf, a binary manifest that tools can memory map
+	// and index by view without parsing JSON.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Binary Manifest"))
+	bool bBinaryManifest;
+
+	// Writes the images into one pack file, capture.spak, instead of a file per
+	// image. Packs are faster to write to network file systems and to copy; the
+	// manifest records where each image is in the pack.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = SeuratSettings, AdvancedDisplay, meta = (DisplayName = "Pack Images"))
+	bool bPackImages;
 };
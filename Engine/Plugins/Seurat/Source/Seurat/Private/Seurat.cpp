@@ -17,11 +17,23 @@
 #include "SeuratConfigWindow.h"
 #include "SceneCaptureSeuratDetail.h"
 #include "JsonManifest.h"
+#include "SeuratMath.h"
+#include "SeuratSampling.h"
+#include "SeuratCheckpoint.h"
+#include "SeuratDepthCodec.h"
+#include "SeuratViewBounds.h"
+#include "SeuratStats.h"
 
 #include "Framework/SlateDelegates.h"
+#include "Misc/App.h"
+#include "Components/SceneCaptureComponentCube.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "Engine/TextureRenderTargetCube.h"
+#include "HAL/FileManager.h"
+#include "Math/PerspectiveMatrix.h"
 #include "Misc/FileHelper.h"
+#include "RenderingThread.h"
+#include "RHIDefinitions.h"
 
 #include "SeuratStyle.h"
 #include "SeuratCommands.h"
@@ -34,12 +46,101 @@
 #include "Kismet/GameplayStatics.h"
 #endif // WITH_EDITOR
 
-static const FString kSeuratOutputDir = FPaths::ConvertRelativePathToFull(FPaths::GameIntermediateDir() / "SeuratCapture");
-static const int32 kTimerExpirationsPerCapture = 4;
+// Resolved on use rather than during static initialization, which may run
+// before the project paths are known when the module is loaded as a shared
+// library.
+FString FSeuratModule::GetDefaultOutputDirectory()
+{
+	return FPaths::ConvertRelativePathToFull(FPaths::GameIntermediateDir() / TEXT("SeuratCapture"));
+}
+// Width and height of the capture images.
+static int32 GetCaptureResolution(const ASceneCaptureSeurat* CaptureCamera)
+{
+	switch (CaptureCamera->Resolution)
+	{
+	case ECaptureResolution::K1536:
+		return 1536;
+	case ECaptureResolution::K8192:
+		return 8192;
+	case ECaptureResolution::K16384:
+		return 16384;
+	default:
+		return FGenericPlatformMath::Pow(2, static_cast<int32>(CaptureCamera->Resolution));
+	}
+}
+// Number of tiles along each axis of a view of |Resolution| pixels.
+static int32 GetTilesPerAxis(int32 Resolution, int32 MaxTileResolution)
+{
+	return FMath::DivideAndRoundUp(Resolution, MaxTileResolution);
+}
+static const int32 kMaxSampleCount = 65536;
+static int32 GetSampleCount(const ASceneCaptureSeurat* CaptureCamera)
+{
+	if (CaptureCamera->SamplesPerFace == EPositionSampleCount::Custom)
+	{
+		return FMath::Clamp(CaptureCamera->CustomSampleCount, 1, kMaxSampleCount);
+	}
+	return FGenericPlatformMath::Pow(2, static_cast<int32>(CaptureCamera->SamplesPerFace));
+}
+static ESeuratSamplePattern GetSamplePattern(const ASceneCaptureSeurat* CaptureCamera)
+{
+	// ECaptureSamplePattern lists the patterns in the same order, followed by
+	// Adaptive, which has no fixed pattern.
+	check(CaptureCamera->SamplePattern != ECaptureSamplePattern::Adaptive);
+	return static_cast<ESeuratSamplePattern>(CaptureCamera->SamplePattern);
+}
+static uint32 GetSampleSeed(const ASceneCaptureSeurat* CaptureCamera)
+{
+	// Only scrambled patterns depend on the seed.
+	const bool bScrambled = CaptureCamera->SamplePattern == ECaptureSamplePattern::ScrambledSobol || CaptureCamera->SamplePattern == ECaptureSamplePattern::Adaptive;
+	return bScrambled ? static_cast<uint32>(CaptureCamera->SampleSeed) : 0;
+}
+// Whether samples are reordered for resolution falloff. Sorting by distance
+// from the center, as samples are generated, suits falloff in cube headboxes.
+static bool UsesRelativeSampleOrder(const ASceneCaptureSeurat* CaptureCamera)
+{
+	return CaptureCamera->ResolutionFalloffLevels > 0 && !IsHeadboxCube(CaptureCamera->HeadboxSize, CaptureCamera->GetTransform());
+}
+// Resolution of the depth cubes of the adaptive sampling and face culling
+// pre-passes.
+static const int32 kPrepassResolution = 64;
+// Depth cubes of the pre-passes rendered ahead of their readback. Rendering is
+// flushed once per this many cubes rather than once per face.
+static const int32 kNumPrepassTargets = 8;
+// Depth edges nearer than this count as this near, in centimeters, so geometry
+// touching a headbox corner doesn't take all samples.
+static const float kCornerMinDepth = 10.0f;
+// Share of the adaptive sample density that is uniform, so every region of the
+// headbox keeps some samples.
+static const float kUniformSampleDensity = 0.25f;
+// Outer samples are never captured at less than this resolution.
+static const int32 kMinSampleResolution = 64;
+// Limits of the tile size of views rendered in tiles.
+static const int32 kMinTileResolution = 256;
+static const int32 kMaxTileResolution = 4096;
+// Pack of the images, if they are packed, in the output directory.
+static const TCHAR* kPackFilename = TEXT("capture.spak");
+static const int32 kNumCubeSides = 6;
+// Face names in ECubeFace order.
+static const TCHAR* kSideNames[kNumCubeSides] = {
+	TEXT("Front"),
+	TEXT("Back"),
+	TEXT("Right"),
+	TEXT("Left"),
+	TEXT("Top"),
+	TEXT("Bottom"),
+};
+
+DECLARE_CYCLE_STAT(TEXT("Tick"), STAT_SeuratTick, STATGROUP_Seurat);
+DECLARE_CYCLE_STAT(TEXT("Issue View"), STAT_SeuratIssueView, STATGROUP_Seurat);
+DECLARE_CYCLE_STAT(TEXT("Position Camera"), STAT_SeuratPositionCamera, STATGROUP_Seurat);
+DECLARE_CYCLE_STAT(TEXT("Capture Scene"), STAT_SeuratCaptureScene, STATGROUP_Seurat);
+DECLARE_CYCLE_STAT(TEXT("Write Image"), STAT_SeuratWriteImage, STATGROUP_Seurat);
 
 #define LOCTEXT_NAMESPACE "FSeuratModule"
 
-FSeuratModule::FSeuratModule() : InitialPosition(FVector::ZeroVector),
+FSeuratModule::FSeuratModule() : NextViewGroup(0), bBinaryManifest(false), bCapturing(false), bLastCaptureSucceeded(false), bCanRender(true), MaxTileResolution(kMaxTileResolution),
+	DepthEncoding(ECaptureDepthEncoding::Exr), ColorCamera(nullptr), NextPoolComponent(0), InitialPosition(FVector::ZeroVector),
 	InitialRotation(FRotator::ZeroRotator), bNeedRestoreRealtime(false),
 	bNeedRestoreGamePaused(false), bNeedRestoreMonitorEditorPerformance(false),
 	WorldFromReferenceCameraMatrixSeurat(FMatrix::Identity)
@@ -53,7 +154,14 @@ bool FSeuratModule::PauseTimeFlow(ASceneCaptureSeurat* InCaptureCamera)
 
 	if (World->WorldType == EWorldType::Editor)
 	{
-		FEditorViewportClient* EditorViewportClient = static_cast<FEditorViewportClient*>(GEditor->GetActiveViewport()->GetClient());
+		// Headless editors, e.g. commandlets, have no viewport to pause.
+		FViewport* ActiveViewport = GEditor != nullptr ? GEditor->GetActiveViewport() : nullptr;
+		if (ActiveViewport == nullptr || ActiveViewport->GetClient() == nullptr)
+		{
+			return true;
+		}
+
+		FEditorViewportClient* EditorViewportClient = static_cast<FEditorViewportClient*>(ActiveViewport->GetClient());
 
 		bool bRealTime = EditorViewportClient->IsRealtime();
 
@@ -89,40 +197,27 @@ void FSeuratModule::RestoreTimeFlow(ASceneCaptureSeurat* InCaptureCamera)
 	UWorld* World = InCaptureCamera->GetWorld();
 	if (bNeedRestoreRealtime && World->WorldType == EWorldType::Editor)
 	{
+		bNeedRestoreRealtime = false;
 		FEditorViewportClient* EditorViewportClient = static_cast<FEditorViewportClient*>(GEditor->GetActiveViewport()->GetClient());
 		EditorViewportClient->SetRealtime(true);
 	}
 	else if (bNeedRestoreGamePaused && World->WorldType == EWorldType::PIE)
 	{
+		bNeedRestoreGamePaused = false;
 		UGameplayStatics::SetGamePaused(World, false);
 	}
 }
 
-// Computes the radical inverse base |DigitBase| of the given value |A|.
-static float RadicalInverse(uint64 A, uint64 DigitBase) {
-	float InvBase = 1.0f / DigitBase;
-	uint64 ReversedDigits = 0;
-	float InvBaseN = 1.0f;
-	// Compute the reversed digits in the base entirely in integer arithmetic.
-	while (A != 0) {
-		uint64 Next = A / DigitBase;
-		uint64 Digit = A - Next * DigitBase;
-		ReversedDigits = ReversedDigits * DigitBase + Digit;
-		InvBaseN *= InvBase;
-		A = Next;
-	}
-	// Only when done are the reversed digits divided by base^n.
-	return FMath::Min(ReversedDigits * InvBaseN, 1.0f);
-}
-
 void FSeuratModule::StartupModule()
 {
 	//Register the tick function here.
 	FWorldDelegates::OnWorldTickStart.AddRaw(this, &FSeuratModule::Tick);
 
-	// Initialize capturing parameters.
-	CurrentSide = 0;
-	CurrentSample = -1;
+	// Commandlets capture without any editor UI.
+	if (IsRunningCommandlet())
+	{
+		return;
+	}
 
 	// Bind the delegate for SceneCaptureCamera UI customization.
 	FPropertyEditorModule& PropertyModule = FModuleManager::GetModuleChecked<FPropertyEditorModule>("PropertyEditor");
@@ -157,6 +252,13 @@ void FSeuratModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FWorldDelegates::OnWorldTickStart.RemoveAll(this);
+
+	if (IsRunningCommandlet())
+	{
+		return;
+	}
+
 	FSeuratStyle::Shutdown();
 
 	FSeuratCommands::Unregister();
@@ -174,65 +276,74 @@ void FSeuratModule::AddToolbarExtension(FToolBarBuilder& Builder)
 {
 }
 
+// Signals when the render thread has executed every command enqueued before it.
+class FSeuratRenderFence : public ISeuratCaptureFence
+{
+public:
+	FSeuratRenderFence()
+	{
+		Fence.BeginFence();
+	}
+
+	virtual bool IsComplete() const override
+	{
+		return Fence.IsFenceComplete();
+	}
+
+private:
+	FRenderCommandFence Fence;
+};
+
 void FSeuratModule::Tick(ELevelTick TickType, float DeltaSeconds)
 {
-	if (CurrentSample < 0)
+	if (!bCapturing)
 	{
 		return;
 	}
+	SCOPE_CYCLE_COUNTER(STAT_SeuratTick);
 
 	// Lose Camera reference. End the capture.
 	if (ColorCameraActor == nullptr || ColorCameraActor->IsPendingKill())
 	{
+		UE_LOG(Seurat, Error, TEXT("Lost Capture Camera reference. Don't modify the scene while capturing."));
 		CancelCapture();
 		return;
 	}
 
-	--CaptureTimer;
-	if (CaptureTimer==0)
+	// Write out color data of every view whose readback has finished.
+	Readback.Tick([this](FSeuratReadbackImage& Image, FIntPoint Size)
 	{
-		// Write out color data.
-		FString ColorImageName = BaseImageName + "_ColorDepth.exr";
-		WriteImage(ColorCamera->TextureTarget, kSeuratOutputDir / ColorImageName, true);
+		return WriteImage(Image, Size);
+	});
+	AppendCompletedViewGroups();
 
-		if (CurrentSample == Samples.Num())
-		{
-			EndCapture();
-		}
+	// Issue the next views as soon as a render target is free, rather than
+	// waiting a fixed number of frames per view.
+	NextPoolComponent = 0;
+	Scheduler.Tick(
+		[this]() { return !bCanRender || Readback.HasFreeSlot(); },
+		[this](const FSeuratCaptureJob& Job) { return CaptureSeurat(Job); });
 
-		CaptureTimer = kTimerExpirationsPerCapture;
-	}
-	else if (CaptureTimer == kTimerExpirationsPerCapture - 1)
+	// The manifest must only be written once every image is on disk.
+	if (Scheduler.IsComplete() && Readback.IsIdle() && ImageWriter.IsIdle())
 	{
-		CaptureSeurat();
+		EndCapture();
 	}
 }
 
-// Convert a transformation matrix in Unreal coordinate system to Seurat's
-// coordinates.
-FMatrix SeuratMatrixFromUnrealMatrix(FMatrix UnrealTransform) {
-	// Use a change of basis to transform the matrix from Unreal's coordinate
-	// system into Seurat's. The matrix SeuratFromUnrealCoordinates encodes
-	// the following change of coordinates:
-	//
-	// Unreal +X is forward and maps to Seurat -Z.
-	// Unreal +Y is right and maps to Seurat +X.
-	// Unreal +Z is up and maps to Seurat +Y.
-	const FMatrix SeuratFromUnrealCoordinates(
-		FPlane(0, 1, 0, 0),
-		FPlane(0, 0, 1, 0),
-		FPlane(-1, 0, 0, 0),
-		FPlane(0, 0, 0, 1));
-
-	// Apply the change of basis, S = P * U * P^-1, to convert Unreal matrix U to
-	// Seurat matrix S. Note that some authors define the change of basis with
-	// the form S = P^-1 * U * P, and in this case P would be the transformation
-	// from Seurat to Unreal coordinates.
-	return SeuratFromUnrealCoordinates * UnrealTransform * SeuratFromUnrealCoordinates.Inverse();
-}
-
-void FSeuratModule::BeginCapture(ASceneCaptureSeurat* InCaptureCamera)
+bool FSeuratModule::BeginCapture(ASceneCaptureSeurat* InCaptureCamera, const FSeuratCaptureOptions& InOptions)
 {
+	// The Capture already began, do nothing.
+	if (bCapturing)
+	{
+		if (!InOptions.bUnattended)
+		{
+			FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("Capture in Progress", "Please wait for current capture progress before start another!"));
+		}
+		UE_LOG(Seurat, Error, TEXT("A capture is already in progress."));
+		return false;
+	}
+
 	// Disable Monitor Editor Performance before capture, so it won't reduce graphic settings and ruin the capture.
 	UEditorPerformanceSettings* EditorPerformanceSettings = GetMutableDefault<UEditorPerformanceSettings>();
 	bNeedRestoreMonitorEditorPerformance = EditorPerformanceSettings->bMonitorEditorPerformance;
@@ -246,135 +357,411 @@ void FSeuratModule::BeginCapture(ASceneCaptureSeurat* InCaptureCamera)
 	if (!PauseTimeFlow(InCaptureCamera))
 	{
 		UE_LOG(Seurat, Error, TEXT("Seurat plugin only runs in Editor or PIE mode!"));
-		return;
+		RestoreEditorState();
+		return false;
 	}
 
 	ColorCameraActor = InCaptureCamera;
+	// Save initial camera state, before any check that may fail and restore it.
+	InitialPosition = ColorCameraActor->GetActorLocation();
+	InitialRotation = ColorCameraActor->GetActorRotation();
+	Options = InOptions;
+	if (Options.OutputDirectory.IsEmpty())
+	{
+		Options.OutputDirectory = GetDefaultOutputDirectory();
+	}
+	bLastCaptureSucceeded = false;
+
+	// The settings that determine the views. A previous capture's checkpoint and
+	// view bounds are only reused if it was made with the same settings.
+	const int32 Resolution = GetCaptureResolution(InCaptureCamera);
+	const int32 NumSamples = GetSampleCount(InCaptureCamera);
+	// Views beyond the tile size are rendered in tiles and streamed to tiled
+	// EXR images, which needs a 2D capture per tile and depth in the image.
+	MaxTileResolution = FMath::Clamp(InCaptureCamera->MaxTileResolution, kMinTileResolution, kMaxTileResolution);
+	const bool bTiled = Resolution > MaxTileResolution;
+	// Single pass cube captures and the depth pre-passes read depth from the
+	// alpha of cube captures, which some engine versions leave without depth.
+	const bool bNeedsCubeDepth = InCaptureCamera->CubeCaptureMode == ECubeCaptureMode::SinglePass || InCaptureCamera->SamplePattern == ECaptureSamplePattern::Adaptive || InCaptureCamera->bCullFaces;
+	const bool bCubeDepth = !bNeedsCubeDepth || !FApp::CanEverRender() || CanCaptureCubeDepth(InCaptureCamera);
+	if (!bCubeDepth)
+	{
+		UE_LOG(Seurat, Warning, TEXT("Cube captures don't write depth with this engine version; faces are captured separately and the depth pre-passes are skipped."));
+	}
+	const bool bCubeCapture = InCaptureCamera->CubeCaptureMode == ECubeCaptureMode::SinglePass && !bTiled && bCubeDepth;
+	DepthEncoding = bTiled ? ECaptureDepthEncoding::Exr : InCaptureCamera->DepthEncoding;
+	if (bTiled && InCaptureCamera->CubeCaptureMode == ECubeCaptureMode::SinglePass)
+	{
+		UE_LOG(Seurat, Warning, TEXT("Views rendered in tiles are captured as separate faces."));
+	}
+	if (bTiled && InCaptureCamera->DepthEncoding != ECaptureDepthEncoding::Exr)
+	{
+		UE_LOG(Seurat, Warning, TEXT("Views rendered in tiles store depth in the EXR images."));
+	}
+	const ECubeCaptureMode CubeCaptureMode = bCubeCapture ? ECubeCaptureMode::SinglePass : ECubeCaptureMode::SeparateFaces;
+	// A partial capture renders a range of the views. Single pass cube jobs
+	// render all sides of a sample, so their ranges must cover whole samples.
+	const int32 NumViews = NumSamples * kNumCubeSides;
+	Options.EndView = Options.EndView == INDEX_NONE ? NumViews : FMath::Clamp(Options.EndView, 0, NumViews);
+	Options.FirstView = FMath::Clamp(Options.FirstView, 0, Options.EndView);
+	const bool bSharded = Options.FirstView > 0 || Options.EndView < NumViews;
+	if (bCubeCapture && (Options.FirstView % kNumCubeSides != 0 || Options.EndView % kNumCubeSides != 0))
+	{
+		UE_LOG(Seurat, Error, TEXT("Single pass cube captures can only capture whole samples; views %d to %d split a sample."), Options.FirstView, Options.EndView);
+		RestoreEditorState();
+		return false;
+	}
+	uint32 SettingsHash = FSeuratCaptureCheckpoint::HashSettings(InCaptureCamera->GetTransform(), InCaptureCamera->HeadboxSize, Resolution, NumSamples, static_cast<int32>(CubeCaptureMode),
+		static_cast<int32>(InCaptureCamera->SamplePattern), GetSampleSeed(InCaptureCamera));
+	// Adaptive samples also depend on the scene, through the corner weights.
+	CornerWeights.Empty();
+	if (InCaptureCamera->SamplePattern == ECaptureSamplePattern::Adaptive)
+	{
+		if (!FApp::CanEverRender() || !bCubeDepth || !MeasureCornerWeights(InCaptureCamera, CornerWeights))
+		{
+			UE_LOG(Seurat, Warning, TEXT("Cannot measure the scene for adaptive sampling; samples are distributed uniformly."));
+			CornerWeights.Init(1.0f, kNumHeadboxCorners);
+		}
+		SettingsHash = FCrc::MemCrc32(CornerWeights.GetData(), CornerWeights.Num() * sizeof(float), SettingsHash);
+	}
+	// With resolution falloff, samples of headboxes that are not cubes are
+	// sorted relative to the headbox size, so the same sample index is a
+	// different view.
+	if (UsesRelativeSampleOrder(InCaptureCamera))
+	{
+		const uint32 kRelativeSampleOrder = 1;
+		SettingsHash = FCrc::MemCrc32(&kRelativeSampleOrder, sizeof(kRelativeSampleOrder), SettingsHash);
+	}
+	// Resolution falloff changes the size of the images, though not the views.
+	if (InCaptureCamera->ResolutionFalloffLevels > 0)
+	{
+		const float Falloff[] = { static_cast<float>(InCaptureCamera->ResolutionFalloffLevels), InCaptureCamera->ResolutionFalloffStart };
+		SettingsHash = FCrc::MemCrc32(Falloff, sizeof(Falloff), SettingsHash);
+	}
+	// So does moving depth out of the images.
+	if (DepthEncoding != ECaptureDepthEncoding::Exr)
+	{
+		const uint8 DepthEncodingValue = static_cast<uint8>(DepthEncoding);
+		SettingsHash = FCrc::MemCrc32(&DepthEncodingValue, sizeof(DepthEncodingValue), SettingsHash);
+	}
+	// Face culling changes which views are captured, and the sky depth which
+	// faces are empty. Hashing them only when culling keeps the hash of
+	// captures without it.
+	if (InCaptureCamera->bCullFaces)
+	{
+		const float CullSettings[] = { InCaptureCamera->CullMinGeometryFraction, InCaptureCamera->CullMaxParallaxPixels, InCaptureCamera->SkyDepth };
+		SettingsHash = FCrc::MemCrc32(CullSettings, sizeof(CullSettings), SettingsHash);
+	}
+	if (!ViewBounds.Load(Options.OutputDirectory / TEXT("view_bounds.json")) || ViewBounds.GetSettingsHash() != SettingsHash)
+	{
+		if (Options.bOnlyChangedViews)
+		{
+			UE_LOG(Seurat, Error, TEXT("%s holds no capture with the same settings to update."), *Options.OutputDirectory);
+			ShowMessage(LOCTEXT("No Capture To Update", "There is no previous capture with the same settings to update. Capture the whole scene first."));
+			RestoreEditorState();
+			return false;
+		}
+		ViewBounds.Reset(SettingsHash);
+	}
 
-	// The Capture already began, do nothing.
-	if (CurrentSample >= 0)
+	// The manifest is written as the capture progresses, so it must be
+	// writable before any view is rendered.
+	IFileManager::Get().MakeDirectory(*Options.OutputDirectory, true);
+	// Tiled images are written to their own files a tile at a time. The images
+	// of partial captures are gathered next to the merged manifest as files.
+	if (bTiled && InCaptureCamera->bPackImages)
 	{
-		FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("Capture in Progress", "Please wait for current capture progress before start another!"));
-		return;
+		UE_LOG(Seurat, Warning, TEXT("Views rendered in tiles are not packed."));
+	}
+	else if (bSharded && InCaptureCamera->bPackImages)
+	{
+		UE_LOG(Seurat, Warning, TEXT("Partial captures are not packed."));
+	}
+	const bool bPackImages = InCaptureCamera->bPackImages && !bTiled && !bSharded && FApp::CanEverRender();
+	// Updating a capture keeps the images of its pack; otherwise only those of
+	// an interrupted capture are kept.
+	if (bPackImages && !Pack.Open(Options.OutputDirectory / kPackFilename, SettingsHash, Options.bOnlyChangedViews))
+	{
+		UE_LOG(Seurat, Error, TEXT("Cannot write the capture pack to %s."), *Options.OutputDirectory);
+		RestoreEditorState();
+		return false;
+	}
+	FSeuratManifestShard Shard;
+	Shard.FirstView = Options.FirstView;
+	Shard.EndView = Options.EndView;
+	Shard.NumViews = NumViews;
+	Shard.ViewsPerGroup = kNumCubeSides;
+	Shard.SettingsHash = SettingsHash;
+	if (!Manifest.Open(Options.OutputDirectory / TEXT("manifest.json"), InCaptureCamera->bCompactManifest, bPackImages ? kPackFilename : FString(), bSharded ? &Shard : nullptr))
+	{
+		Pack.Close();
+		UE_LOG(Seurat, Error, TEXT("Cannot write the capture manifest to %s."), *Options.OutputDirectory);
+		RestoreEditorState();
+		return false;
+	}
+	// The merged manifest of a partial capture is converted instead.
+	bBinaryManifest = InCaptureCamera->bBinaryManifest && !bSharded;
+	BinaryManifest.Reset();
+	if (bPackImages)
+	{
+		BinaryManifest.SetPackPath(kPackFilename);
 	}
 
-	// Save initial camera state.
-	InitialPosition = ColorCameraActor->GetActorLocation();
-	InitialRotation = ColorCameraActor->GetActorRotation();
+	bCanRender = FApp::CanEverRender();
+	if (!bCanRender)
+	{
+		UE_LOG(Seurat, Warning, TEXT("Rendering is unavailable; only the capture manifest will be written."));
+	}
 
 	// Calculate this matrix before changing capture camera postion.
 	WorldFromReferenceCameraMatrixSeurat = SeuratMatrixFromUnrealMatrix(
 		ColorCameraActor->GetTransform().ToMatrixNoScale());
 
 	ColorCamera = ColorCameraActor->GetCaptureComponent2D();
-	ColorCamera->TextureTarget = NewObject<UTextureRenderTarget2D>();
-	int32 InResolution = static_cast<int32>(ColorCameraActor->Resolution);
-	int32 Resolution = InResolution == 13 ? 1536 : FGenericPlatformMath::Pow(2, InResolution);
 	ColorCamera->CaptureSource = ESceneCaptureSource::SCS_SceneColorSceneDepth;
-	ColorCamera->TextureTarget->InitCustomFormat(Resolution, Resolution, PF_FloatRGBA, true);
 
-	Samples.Empty();
-	FVector HeadboxSize = ColorCameraActor->HeadboxSize;
-	int32 SamplesPerFace = FGenericPlatformMath::Pow(2, static_cast<int32>(ColorCameraActor->SamplesPerFace));
-	// Use Hammersly sampling for reproduciblity.
-	for (int32 SampleIndex = 0; SampleIndex < SamplesPerFace; ++SampleIndex)
-	{
-		FVector HeadboxPosition = FVector(
-			(float)SampleIndex / (float)(SamplesPerFace - 1),
-			RadicalInverse((uint64)SampleIndex, 2),
-			RadicalInverse((uint64)SampleIndex, 3));
-		HeadboxPosition.X *= HeadboxSize.X;
-		HeadboxPosition.Y *= HeadboxSize.Y;
-		HeadboxPosition.Z *= HeadboxSize.Z;
-		HeadboxPosition -= HeadboxSize * 0.5f;
-		// Headbox samples are in camera space; transform to world space.
-		HeadboxPosition = ColorCameraActor->GetTransform().TransformPosition(HeadboxPosition);
-		Samples.Add(HeadboxPosition);
-	}
-
-	FVector CameraLocation = ColorCameraActor->GetActorLocation();
-
-	// Sort samples by distance from center of the headbox.
-	Samples.Sort([&CameraLocation](const FVector& V1, const FVector& V2) {
-		return (V1 - CameraLocation).Size() < (V2 - CameraLocation).Size();
-	});
+	// Every pool component needs its own render target in flight, and all
+	// targets together must fit in the capture memory budget. Tiled views only
+	// need targets of a tile.
+	const int32 TileResolution = FMath::DivideAndRoundUp(Resolution, GetTilesPerAxis(Resolution, MaxTileResolution));
+	const int64 TargetSizeBytes = static_cast<int64>(TileResolution) * TileResolution * GPixelFormats[PF_FloatRGBA].BlockBytes * (bCubeCapture ? kNumCubeSides : 1);
+	const int64 CaptureMemoryBudgetBytes = static_cast<int64>(ColorCameraActor->CaptureMemoryBudgetMB) * 1024 * 1024;
+	const int32 MaxRenderTargets = static_cast<int32>(FMath::Clamp<int64>(CaptureMemoryBudgetBytes / TargetSizeBytes, 1, MAX_int32));
+	const int32 PoolSize = FMath::Clamp(ColorCameraActor->CaptureComponentPoolSize, 1, MaxRenderTargets);
+	const int32 NumRenderTargets = FMath::Clamp(ColorCameraActor->ReadbackBufferCount, PoolSize, MaxRenderTargets);
+	if (PoolSize < ColorCameraActor->CaptureComponentPoolSize)
+	{
+		UE_LOG(Seurat, Warning, TEXT("Capture memory budget limits the capture component pool to %d components."), PoolSize);
+	}
+
+	CreateCapturePool(PoolSize, bCubeCapture);
+	Report.Begin();
+	PixelBufferPool.Configure(TileResolution * TileResolution);
+	PixelBufferPool.ResetStats();
+	if (bCanRender)
+	{
+		Readback.Initialize(NumRenderTargets, TileResolution, bCubeCapture, PixelBufferPool);
+	}
+	if (bTiled)
+	{
+		UE_LOG(Seurat, Log, TEXT("Rendering views of %d pixels in tiles of %d pixels."), Resolution, TileResolution);
+	}
+	FSeuratExrSettings ExrSettings;
+	ExrSettings.Compression = ColorCameraActor->ExrCompression;
+	ExrSettings.DepthPrecision = ColorCameraActor->DepthPrecision;
+	ExrSettings.DepthEncoding = DepthEncoding;
+	ImageWriter.Start(ColorCameraActor->WriterThreadCount, static_cast<int64>(ColorCameraActor->WriterMemoryBudgetMB) * 1024 * 1024, ExrSettings, PixelBufferPool,
+		Pack.IsOpen() ? &Pack : nullptr);
+
+	if (ColorCameraActor->SamplePattern == ECaptureSamplePattern::Adaptive)
+	{
+		GenerateAdaptiveHeadboxSamples(NumSamples, ColorCameraActor->HeadboxSize, ColorCameraActor->GetTransform(), CornerWeights, GetSampleSeed(ColorCameraActor), Samples);
+	}
+	else
+	{
+		GenerateHeadboxSamples(NumSamples, ColorCameraActor->HeadboxSize, ColorCameraActor->GetTransform(), Samples, GetSamplePattern(ColorCameraActor), GetSampleSeed(ColorCameraActor));
+	}
+	// Views are issued in sample order, from the center outwards, so resolutions
+	// only ever decrease during a capture. Headboxes that are not cubes need the
+	// samples sorted by the distance the levels depend on; in cubes, taking the
+	// running maximum only absorbs rounding between world and headbox distances.
+	if (UsesRelativeSampleOrder(ColorCameraActor.Get()))
+	{
+		SortSamplesForResolutionFalloff(Samples, ColorCameraActor->HeadboxSize, ColorCameraActor->GetTransform());
+	}
+	SampleResolutions.Empty(Samples.Num());
+	int32 Level = 0;
+	for (const FVector& Sample : Samples)
+	{
+		Level = FMath::Max(Level, GetSampleResolutionLevel(Sample, ColorCameraActor->HeadboxSize, ColorCameraActor->GetTransform(),
+			ColorCameraActor->ResolutionFalloffStart, ColorCameraActor->ResolutionFalloffLevels));
+		SampleResolutions.Add(FMath::Max(Resolution >> Level, kMinSampleResolution));
+	}
+
+	FaceCulls.Empty();
+	if (ColorCameraActor->bCullFaces && bCanRender && bCubeDepth && !CullFaces(Resolution))
+	{
+		UE_LOG(Seurat, Warning, TEXT("Cannot render the face culling pre-pass; every face is captured."));
+		FaceCulls.Empty();
+	}
 
-	// Replace the sample closest to the center of the headbox with a sample at
-	// exactly the center. This is important because Seurat requires
-	// sampling information at the center of the headbox.
-	Samples[0] = CameraLocation;
+	PendingViewGroups.Empty();
+	NextViewGroup = Options.FirstView / kNumCubeSides;
+	// A single pass cube capture renders all sides of a sample in one job. Each
+	// pool component renders at least one job per tick.
+	TArray<int32> SampleTileCounts;
+	if (bTiled)
+	{
+		for (int32 SampleResolution : SampleResolutions)
+		{
+			SampleTileCounts.Add(FMath::Square(GetTilesPerAxis(SampleResolution, MaxTileResolution)));
+		}
+	}
+	Scheduler.Reset(Samples.Num(), bCubeCapture ? 1 : kNumCubeSides, FMath::Max(ColorCameraActor->ViewsPerTick, PoolSize), NumRenderTargets, SampleTileCounts);
+	if (bSharded)
+	{
+		Scheduler.RemoveJobs([this](const FSeuratCaptureJob& Job)
+		{
+			return !IsViewInRange(Job.SampleIndex, Job.SideIndex);
+		});
+		UE_LOG(Seurat, Log, TEXT("Capturing views %d to %d of %d."), Options.FirstView, Options.EndView, NumViews);
+	}
 
-	ViewGroups.Empty();
-	CurrentSample = 0;
-	CurrentSide = 0;
-	CaptureTimer = kTimerExpirationsPerCapture;
+	// Keep the images of an interrupted capture of the same views and, when
+	// updating a capture, the images of views the scene change cannot affect.
+	// Jobs with reusable images or culled sides only add their views to the
+	// manifest.
+	if (bCanRender)
+	{
+		if (!Pack.IsOpen() && !Checkpoint.Open(Options.OutputDirectory / TEXT("checkpoint.txt"), SettingsHash))
+		{
+			UE_LOG(Seurat, Warning, TEXT("The capture cannot be resumed if it is interrupted."));
+		}
+		const int32 NumSkippedJobs = Scheduler.RemoveJobs([this](const FSeuratCaptureJob& Job)
+		{
+			if (!CanReuseImages(Job))
+			{
+				return false;
+			}
+			// The tiles of a view share its image and view.
+			if (Job.TileIndex == 0)
+			{
+				AddViewsWithoutCapture(Job);
+			}
+			return true;
+		});
+		if (NumSkippedJobs > 0)
+		{
+			UE_LOG(Seurat, Log, TEXT("Reusing the images of %d of %d capture jobs."), NumSkippedJobs, NumSkippedJobs + Scheduler.GetNumJobs());
+		}
+	}
+	bCapturing = true;
+	return true;
 }
 
 void FSeuratModule::EndCapture()
 {
-	// From Json array to a string.
-	TSharedPtr<FJsonObject> SeuratManifest = MakeShareable(new FJsonObject());
-	SeuratManifest->SetArrayField("view_groups", ViewGroups);
-	GenerateJson(SeuratManifest, kSeuratOutputDir);
+	// Every image is written by now; append the remaining view groups.
+	AppendCompletedViewGroups();
+	const int32 NumViewGroups = Options.EndView > Options.FirstView ? FMath::DivideAndRoundUp(Options.EndView, kNumCubeSides) - Options.FirstView / kNumCubeSides : 0;
+	const bool bManifestWritten = Manifest.GetNumViewGroups() == NumViewGroups;
+	Manifest.Close();
+	if (bBinaryManifest && !BinaryManifest.Save(Options.OutputDirectory / TEXT("manifest.") + SEURAT_BINARY_MANIFEST_EXTENSION))
+	{
+		UE_LOG(Seurat, Error, TEXT("Cannot write the binary capture manifest to %s."), *Options.OutputDirectory);
+	}
+	BinaryManifest.Reset();
 	Samples.Empty();
-	ViewGroups.Empty();
-	CurrentSample = -1;
-
-	// Restore camera state.
-	ColorCameraActor->SetActorLocation(InitialPosition);
-	ColorCameraActor->SetActorRotation(InitialRotation);
-
-	RestoreTimeFlow(ColorCameraActor.Get());
-
-	// Restore Monitor Editor Performance as it is before the capture.
-	UEditorPerformanceSettings* EditorPerformanceSettings = GetMutableDefault<UEditorPerformanceSettings>();
-	EditorPerformanceSettings->bMonitorEditorPerformance = bNeedRestoreMonitorEditorPerformance;
+	PendingViewGroups.Empty();
+	bCapturing = false;
+	Readback.Release();
+	ReleaseCapturePool();
+	ImageWriter.Stop(false);
+	if (ImageWriter.GetNumFailedWrites() > 0)
+	{
+		UE_LOG(Seurat, Error, TEXT("%d capture images could not be written."), ImageWriter.GetNumFailedWrites());
+	}
+	bLastCaptureSucceeded = bManifestWritten && ImageWriter.GetNumFailedWrites() == 0;
+	// Like the checkpoint, a complete pack has nothing left to resume.
+	Pack.Close(bLastCaptureSucceeded);
+
+	Report.End();
+	Report.Save(Options.OutputDirectory / TEXT("capture_report.json"));
+	UE_LOG(Seurat, Log, TEXT("Captured %d views in %.1f seconds, writing %.1f MB."),
+		Report.GetNumViews(), Report.GetTotalSeconds(), Report.GetBytesWritten() / (1024.0 * 1024.0));
+
+	const FSeuratPixelBufferPoolStats PoolStats = PixelBufferPool.GetStats();
+	UE_LOG(Seurat, Log, TEXT("Pixel buffers: %lld acquired, %lld allocated, peak %d in use (%.1f MB)."),
+		PoolStats.NumAcquires, PoolStats.NumAllocations, PoolStats.PeakInUse, PoolStats.PeakBytesInUse / (1024.0 * 1024.0));
+	if (bCanRender)
+	{
+		ViewBounds.Save(Options.OutputDirectory / TEXT("view_bounds.json"));
+	}
+	// A complete capture has nothing left to resume.
+	if (bLastCaptureSucceeded)
+	{
+		Checkpoint.Delete();
+	}
+	else
+	{
+		Checkpoint.Close();
+	}
 
-	UEditorPerProjectUserSettings* EditorUserSettings = GetMutableDefault<UEditorPerProjectUserSettings>();
-	EditorUserSettings->PostEditChange();
-	EditorUserSettings->SaveConfig();
+	RestoreEditorState();
 
-	ColorCamera->TextureTarget = nullptr;
-	ColorCamera = nullptr;
-	ColorCameraActor = nullptr;
+	UE_LOG(Seurat, Log, TEXT("Scene captured to %s."), *Options.OutputDirectory);
+	ShowMessage(LOCTEXT("Scene Captured!", "Scene Captured!"));
+}
 
-	const EAppReturnType::Type Choice = FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("Scene Captured!", "Scene Captured!"));
+void FSeuratModule::ShowMessage(const FText& Message)
+{
+	if (!Options.bUnattended && !FApp::IsUnattended())
+	{
+		FMessageDialog::Open(EAppMsgType::Ok, Message);
+	}
 }
 
 void FSeuratModule::CancelCapture()
 {
+	// The manifest already on disk lists the view groups completed so far, and
+	// the checkpoint the images a restarted capture can keep.
+	Manifest.Close();
+	if (bBinaryManifest)
+	{
+		BinaryManifest.Save(Options.OutputDirectory / TEXT("manifest.") + SEURAT_BINARY_MANIFEST_EXTENSION);
+		BinaryManifest.Reset();
+	}
+	Checkpoint.Close();
+	if (bCanRender)
+	{
+		ViewBounds.Save(Options.OutputDirectory / TEXT("view_bounds.json"));
+	}
 	Samples.Empty();
-	ViewGroups.Empty();
-	CurrentSample = -1;
-
-	ColorCamera = nullptr;
-	ColorCameraActor = nullptr;
-
-	UE_LOG(Seurat, Error, TEXT("Lost Capture Camera reference. Don't modify the scene while capturing."));
+	PendingViewGroups.Empty();
+	bCapturing = false;
+	Readback.Release();
+	ReleaseCapturePool();
+	ImageWriter.Stop(true);
+	Pack.Close();
+
+	RestoreEditorState();
 }
 
-void FSeuratModule::CaptureSeurat()
+void FSeuratModule::RestoreEditorState()
 {
-	FString BaseName = "Cube";
+	// A capture camera deleted during the capture is pending kill, but its
+	// world still needs its time flow restored.
+	ASceneCaptureSeurat* CaptureCamera = ColorCameraActor.Get(true);
+	if (CaptureCamera != nullptr)
+	{
+		// Restore camera state.
+		if (!CaptureCamera->IsPendingKill())
+		{
+			CaptureCamera->SetActorLocation(InitialPosition);
+			CaptureCamera->SetActorRotation(InitialRotation);
+		}
+		RestoreTimeFlow(CaptureCamera);
+	}
 
-	TArray<FString> Sides = {
-		"Front",
-		"Back",
-		"Right",
-		"Left",
-		"Top",
-		"Bottom",
-	};
+	// Restore Monitor Editor Performance as it is before the capture.
+	UEditorPerformanceSettings* EditorPerformanceSettings = GetMutableDefault<UEditorPerformanceSettings>();
+	EditorPerformanceSettings->bMonitorEditorPerformance = bNeedRestoreMonitorEditorPerformance;
+
+	UEditorPerProjectUserSettings* EditorUserSettings = GetMutableDefault<UEditorPerProjectUserSettings>();
+	EditorUserSettings->PostEditChange();
+	EditorUserSettings->SaveConfig();
 
-	if (CurrentSide == 0)
+	if (ColorCamera != nullptr)
 	{
-		ViewGroup = MakeShareable(new FJsonObject());
-		Views.Empty();
+		ColorCamera->TextureTarget = nullptr;
 	}
+	ColorCamera = nullptr;
+	ColorCameraActor = nullptr;
+}
 
-	int32 NumSides = Sides.Num();
-	int32 Side = CurrentSide;
-	FString SideName = Sides[Side];
+// Rotation of the capture camera for each side, in ECubeFace order.
+static FRotator GetFaceRotation(int32 Side)
+{
 	FRotator FaceRotation = FRotator::ZeroRotator;
 	switch (Side)
 	{
@@ -398,27 +785,528 @@ void FSeuratModule::CaptureSeurat()
 	default:
 		break;
 	}
+	return FaceRotation;
+}
+
+static FString GetBaseImageName(int32 SampleIndex, int32 Side)
+{
+	FString BaseName = "Cube";
+	return BaseName + "_" + kSideNames[Side] + "_" + FString::FromInt(SampleIndex);
+}
+
+// First pixel of a tile of a view. Tiles are numbered row by row from the top
+// left, like the pixels of the image.
+static FIntPoint GetTileOffset(int32 TileIndex, int32 TilesPerAxis, int32 TileResolution)
+{
+	return FIntPoint(TileIndex % TilesPerAxis, TileIndex / TilesPerAxis) * TileResolution;
+}
 
-	BaseImageName = BaseName + "_" + SideName + "_" + FString::FromInt(CurrentSample);
-	TSharedPtr<FJsonObject> View = Capture(FaceRotation, Samples[CurrentSample]);
-	Views.Add(MakeShareable(new FJsonValueObject(View.ToSharedRef())));
+// Projection of the part of a 90 degree view of |Resolution| pixels that the
+// tile at |TileOffset| covers. Starts from the projection the capture
+// component builds for the whole view, then scales and shifts clip space so
+// the tile fills it. Clip space Y points up, against the image rows.
+static FMatrix GetTileProjectionMatrix(FIntPoint TileOffset, int32 TileResolution, int32 Resolution)
+{
+	const float HalfFOV = 0.25f * PI;
+	FMatrix Projection = static_cast<int32>(ERHIZBuffer::IsInverted) != 0
+		? FMatrix(FReversedZPerspectiveMatrix(HalfFOV, HalfFOV, 1.0f, 1.0f, GNearClippingPlane, GNearClippingPlane))
+		: FMatrix(FPerspectiveMatrix(HalfFOV, HalfFOV, 1.0f, 1.0f, GNearClippingPlane, GNearClippingPlane));
+	const float Scale = static_cast<float>(Resolution) / TileResolution;
+	Projection.M[0][0] *= Scale;
+	Projection.M[1][1] *= Scale;
+	Projection.M[2][0] = static_cast<float>(Resolution - 2 * TileOffset.X - TileResolution) / TileResolution;
+	Projection.M[2][1] = static_cast<float>(2 * TileOffset.Y + TileResolution - Resolution) / TileResolution;
+	return Projection;
+}
 
-	++CurrentSide;
-	if (CurrentSide == NumSides)
+TSharedRef<ISeuratCaptureFence> FSeuratModule::CaptureSeurat(const FSeuratCaptureJob& Job)
+{
+	if (CubeCameras.Num() > 0)
 	{
-		CurrentSide = 0;
-		++CurrentSample;
-		ViewGroup->SetArrayField("views", Views);
-		ViewGroups.Add(MakeShareable(new FJsonValueObject(ViewGroup)));
-		ViewGroup.Reset();
+		return CaptureSeuratCube(Job);
 	}
+	SCOPE_CYCLE_COUNTER(STAT_SeuratIssueView);
+	const double IssueStartTime = FPlatformTime::Seconds();
+	USceneCaptureComponent2D* Camera = ColorCameras[NextPoolComponent++ % ColorCameras.Num()];
+
+	BaseImageName = GetBaseImageName(Job.SampleIndex, Job.SideIndex);
+	const int32 Resolution = SampleResolutions[Job.SampleIndex];
+	const int32 TilesPerAxis = GetTilesPerAxis(Resolution, MaxTileResolution);
+	const int32 TileResolution = FMath::DivideAndRoundUp(Resolution, TilesPerAxis);
+	if (bCanRender)
+	{
+		Camera->TextureTarget = CastChecked<UTextureRenderTarget2D>(Readback.AcquireTarget(TileResolution));
+		Camera->bUseCustomProjectionMatrix = TilesPerAxis > 1;
+		if (TilesPerAxis > 1)
+		{
+			Camera->CustomProjectionMatrix = GetTileProjectionMatrix(GetTileOffset(Job.TileIndex, TilesPerAxis, TileResolution), TileResolution, Resolution);
+		}
+	}
+	FSeuratPendingViewGroup& ViewGroup = FindOrAddViewGroup(Job.SampleIndex);
+	const SeuratView View = Capture(Camera, GetFaceRotation(Job.SideIndex), Samples[Job.SampleIndex], Resolution);
+	// A tiled view is added with its first tile, and its image is pending until
+	// the last tile is written.
+	if (Job.TileIndex == 0)
+	{
+		ViewGroup.Views[Job.SideIndex] = View;
+		++ViewGroup.NumViews;
+	}
+	if (bCanRender)
+	{
+		Readback.Submit({ Options.OutputDirectory / (BaseImageName + "_ColorDepth.exr") }, Job.SampleIndex, Job.TileIndex);
+		ViewGroup.NumPendingImages += Job.TileIndex == 0 ? 1 : 0;
+	}
+	Report.FindOrAddView(BaseImageName + "_ColorDepth.exr").IssueSeconds += FPlatformTime::Seconds() - IssueStartTime;
+
+	return MakeShareable(new FSeuratRenderFence());
 }
 
-TSharedPtr<FJsonObject> FSeuratModule::Capture(FRotator Orientation, FVector Position)
+TSharedRef<ISeuratCaptureFence> FSeuratModule::CaptureSeuratCube(const FSeuratCaptureJob& Job)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SeuratIssueView);
+	const double IssueStartTime = FPlatformTime::Seconds();
+	const FVector Position = Samples[Job.SampleIndex];
+	FSeuratPendingViewGroup& ViewGroup = FindOrAddViewGroup(Job.SampleIndex);
+
+	// Render all faces of the sample at once; cube captures ignore rotation.
+	USceneCaptureComponentCube* CubeCamera = CubeCameras[NextPoolComponent++ % CubeCameras.Num()];
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SeuratPositionCamera);
+		CubeCamera->SetWorldLocation(Position);
+	}
+	if (bCanRender)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SeuratCaptureScene);
+		CubeCamera->TextureTarget = CastChecked<UTextureRenderTargetCube>(Readback.AcquireTarget(SampleResolutions[Job.SampleIndex]));
+		CubeCamera->CaptureScene();
+	}
+
+	// The cube faces are in the same order as the sides of CaptureSeurat, so the
+	// file names and view order match the separate face capture.
+	// Culled sides are rendered with the others, but their images are dropped
+	// rather than written.
+	TArray<FString> Filenames;
+	int32 NumImages = 0;
+	for (int32 Side = 0; Side < kNumCubeSides; ++Side)
+	{
+		if (GetFaceCull(Job.SampleIndex, Side) != ESeuratFaceCull::None)
+		{
+			AddCulledView(ViewGroup, Job.SampleIndex, Side);
+			Filenames.Add(FString());
+			continue;
+		}
+		BaseImageName = GetBaseImageName(Job.SampleIndex, Side);
+		ViewGroup.Views[Side] = MakeView(CubeFaceWorldFromEye(Side, Position), SampleResolutions[Job.SampleIndex]);
+		++ViewGroup.NumViews;
+		Filenames.Add(Options.OutputDirectory / (BaseImageName + "_ColorDepth.exr"));
+		++NumImages;
+	}
+	if (bCanRender)
+	{
+		Readback.Submit(Filenames, Job.SampleIndex);
+		ViewGroup.NumPendingImages += NumImages;
+	}
+	const double IssueSecondsPerView = (FPlatformTime::Seconds() - IssueStartTime) / FMath::Max(NumImages, 1);
+	for (const FString& Filename : Filenames)
+	{
+		if (!Filename.IsEmpty())
+		{
+			Report.FindOrAddView(FPaths::GetCleanFilename(Filename)).IssueSeconds = IssueSecondsPerView;
+		}
+	}
+
+	return MakeShareable(new FSeuratRenderFence());
+}
+
+FMatrix FSeuratModule::GetViewWorldFromEye(int32 SampleIndex, int32 Side) const
+{
+	// Matches the camera placement of CaptureSeurat and CaptureSeuratCube.
+	const FVector Position = Samples[SampleIndex];
+	if (CubeCameras.Num() > 0)
+	{
+		return CubeFaceWorldFromEye(Side, Position);
+	}
+	return FTransform(GetFaceRotation(Side), Position).ToMatrixNoScale();
+}
+
+bool FSeuratModule::CanReuseImages(const FSeuratCaptureJob& Job) const
+{
+	// A single pass cube job covers every side of its sample.
+	const bool bCubeJob = CubeCameras.Num() > 0;
+	const int32 FirstSide = bCubeJob ? 0 : Job.SideIndex;
+	const int32 EndSide = bCubeJob ? kNumCubeSides : Job.SideIndex + 1;
+	for (int32 Side = FirstSide; Side < EndSide; ++Side)
+	{
+		if (GetFaceCull(Job.SampleIndex, Side) != ESeuratFaceCull::None)
+		{
+			continue;
+		}
+		const FString Filename = Options.OutputDirectory / (GetBaseImageName(Job.SampleIndex, Side) + "_ColorDepth.exr");
+		if (IsImageComplete(Filename))
+		{
+			continue;
+		}
+		if (Options.bOnlyChangedViews && !ViewMayShowChange(GetViewWorldFromEye(Job.SampleIndex, Side), Filename))
+		{
+			continue;
+		}
+		return false;
+	}
+	return true;
+}
+
+bool FSeuratModule::ViewMayShowChange(const FMatrix& WorldFromEye, const FString& Filename) const
+{
+	// Views without recorded bounds or image are captured again.
+	const FSeuratViewDepthRange* DepthRange = ViewBounds.FindDepthRange(FPaths::GetCleanFilename(Filename));
+	FSeuratPackEntry Entry;
+	const bool bImageExists = Pack.IsOpen() ? Pack.FindEntry(FPaths::GetCleanFilename(Filename), Entry) : IFileManager::Get().FileExists(*Filename);
+	if (DepthRange == nullptr || !bImageExists)
+	{
+		return true;
+	}
+	for (const FBox& Box : Options.ChangedBounds)
+	{
+		if (SeuratViewMayShowBox(WorldFromEye, GNearClippingPlane, DepthRange->MaxDepth, Box))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FSeuratModule::IsImageComplete(const FString& Filename) const
+{
+	// A pack also holds the images of the capture it updates, which are only
+	// reused if the scene change cannot affect their views.
+	if (Pack.IsOpen())
+	{
+		return Pack.IsResumable(FPaths::GetCleanFilename(Filename));
+	}
+	return Checkpoint.IsOpen() && Checkpoint.IsImageComplete(Filename);
+}
+
+void FSeuratModule::AddViewsWithoutCapture(const FSeuratCaptureJob& Job)
+{
+	const bool bCubeJob = CubeCameras.Num() > 0;
+	const int32 FirstSide = bCubeJob ? 0 : Job.SideIndex;
+	const int32 EndSide = bCubeJob ? kNumCubeSides : Job.SideIndex + 1;
+	FSeuratPendingViewGroup& ViewGroup = FindOrAddViewGroup(Job.SampleIndex);
+	for (int32 Side = FirstSide; Side < EndSide; ++Side)
+	{
+		if (GetFaceCull(Job.SampleIndex, Side) != ESeuratFaceCull::None)
+		{
+			AddCulledView(ViewGroup, Job.SampleIndex, Side);
+			continue;
+		}
+		BaseImageName = GetBaseImageName(Job.SampleIndex, Side);
+		ViewGroup.Views[Side] = MakeView(GetViewWorldFromEye(Job.SampleIndex, Side), SampleResolutions[Job.SampleIndex]);
+		++ViewGroup.NumViews;
+	}
+}
+
+ESeuratFaceCull FSeuratModule::GetFaceCull(int32 SampleIndex, int32 Side) const
+{
+	return FaceCulls.Num() > 0 ? FaceCulls[SampleIndex * kNumCubeSides + Side] : ESeuratFaceCull::None;
+}
+
+void FSeuratModule::AddCulledView(FSeuratPendingViewGroup& ViewGroup, int32 SampleIndex, int32 Side)
+{
+	SeuratCulledFace CulledFace;
+	CulledFace.Face = kSideNames[Side];
+	CulledFace.Reason = GetSeuratFaceCullName(GetFaceCull(SampleIndex, Side));
+	ViewGroup.CulledFaces.Add(CulledFace);
+	ViewGroup.CulledSides |= 1u << Side;
+	++ViewGroup.NumViews;
+}
+
+FSeuratPendingViewGroup& FSeuratModule::FindOrAddViewGroup(int32 SampleIndex)
+{
+	FSeuratPendingViewGroup* ViewGroup = PendingViewGroups.Find(SampleIndex);
+	if (ViewGroup == nullptr)
+	{
+		ViewGroup = &PendingViewGroups.Add(SampleIndex);
+		ViewGroup->Views.SetNum(kNumCubeSides);
+	}
+	return *ViewGroup;
+}
+
+bool FSeuratModule::IsViewInRange(int32 SampleIndex, int32 Side) const
+{
+	const int32 View = SampleIndex * kNumCubeSides + Side;
+	return View >= Options.FirstView && View < Options.EndView;
+}
+
+int32 FSeuratModule::GetNumViewsInRange(int32 SampleIndex) const
+{
+	const int32 FirstSampleView = SampleIndex * kNumCubeSides;
+	return FMath::Clamp(Options.EndView - FirstSampleView, 0, kNumCubeSides) - FMath::Clamp(Options.FirstView - FirstSampleView, 0, kNumCubeSides);
+}
+
+int32 FSeuratModule::GetNumCaptureViews(const ASceneCaptureSeurat* InCaptureCamera) const
+{
+	return GetSampleCount(InCaptureCamera) * kNumCubeSides;
+}
+
+// Creates a cube capture component that renders low resolution depth cubes
+// for the pre-passes of adaptive sampling and face culling.
+static USceneCaptureComponentCube* CreateDepthPrepassCamera(ASceneCaptureSeurat* InCaptureCamera)
+{
+	USceneCaptureComponentCube* CubeCamera = NewObject<USceneCaptureComponentCube>(InCaptureCamera, NAME_None, RF_Transient);
+	CubeCamera->bCaptureEveryFrame = false;
+	CubeCamera->bCaptureOnMovement = false;
+	CubeCamera->CaptureSource = ESceneCaptureSource::SCS_SceneColorSceneDepth;
+	CubeCamera->ShowFlags = InCaptureCamera->GetCaptureComponent2D()->ShowFlags;
+	CubeCamera->RegisterComponent();
+	return CubeCamera;
+}
+
+static void DestroyDepthPrepassCamera(USceneCaptureComponentCube* CubeCamera)
+{
+	CubeCamera->TextureTarget = nullptr;
+	CubeCamera->DestroyComponent();
+}
+
+// Renders the depth of each cube face at each of |Positions|, in centimeters,
+// and passes the faces of each position, in ECubeFace order, to |OnDepthCube|
+// in position order. Cubes are read back through a readback ring, so several
+// render before the game thread waits for the oldest one.
+static bool RenderDepthCubes(USceneCaptureComponentCube* CubeCamera, const TArray<FVector>& Positions,
+	TFunctionRef<void(int32 PositionIndex, const TArray<TArray<float>>& FaceDepths)> OnDepthCube)
+{
+	FSeuratPixelBufferPool BufferPool;
+	FSeuratReadbackRing Ring;
+	Ring.Initialize(FMath::Min(Positions.Num(), kNumPrepassTargets), kPrepassResolution, true, BufferPool);
+
+	TArray<FString> FaceNames;
+	FaceNames.SetNum(CubeFace_MAX);
+	TArray<TArray<float>> FaceDepths;
+	FaceDepths.SetNum(CubeFace_MAX);
+	int32 NumFacesRead = 0;
+	bool bSucceeded = true;
+	auto OnReadbackComplete = [&](FSeuratReadbackImage& Image, FIntPoint Size)
+	{
+		// Faces are reported in submission order, so a running count gives the
+		// face of each image.
+		const int32 Face = NumFacesRead++ % CubeFace_MAX;
+		TArray<float>& Depths = FaceDepths[Face];
+		bSucceeded &= Image.Pixels.Num() == Size.X * Size.Y;
+		// Depth is in the alpha channel.
+		Depths.SetNumUninitialized(Image.Pixels.Num());
+		for (int32 PixelIndex = 0; PixelIndex < Image.Pixels.Num(); ++PixelIndex)
+		{
+			Depths[PixelIndex] = Image.Pixels[PixelIndex].A.GetFloat();
+		}
+		BufferPool.Release(MoveTemp(Image.Pixels));
+		if (Face == CubeFace_MAX - 1 && bSucceeded)
+		{
+			OnDepthCube(Image.Tag, FaceDepths);
+		}
+		return true;
+	};
+
+	for (int32 PositionIndex = 0; PositionIndex < Positions.Num() && bSucceeded; ++PositionIndex)
+	{
+		UTextureRenderTarget* Target = Ring.AcquireTarget();
+		while (Target == nullptr)
+		{
+			// Completes every cube rendered so far.
+			FlushRenderingCommands();
+			Ring.Tick(OnReadbackComplete);
+			Target = Ring.AcquireTarget();
+		}
+		CubeCamera->TextureTarget = CastChecked<UTextureRenderTargetCube>(Target);
+		CubeCamera->SetWorldLocation(Positions[PositionIndex]);
+		CubeCamera->CaptureScene();
+		Ring.Submit(FaceNames, PositionIndex);
+	}
+	while (!Ring.IsIdle())
+	{
+		FlushRenderingCommands();
+		Ring.Tick(OnReadbackComplete);
+	}
+	CubeCamera->TextureTarget = nullptr;
+	Ring.Release();
+	return bSucceeded;
+}
+
+bool FSeuratModule::CanCaptureCubeDepth(ASceneCaptureSeurat* InCaptureCamera)
+{
+	// Color alpha is at most one, while depth is in centimeters, and the sky or
+	// far plane is far beyond one. A cube with no alpha above one has no depth.
+	USceneCaptureComponentCube* CubeCamera = CreateDepthPrepassCamera(InCaptureCamera);
+	bool bHasDepth = false;
+	RenderDepthCubes(CubeCamera, { InCaptureCamera->GetActorLocation() }, [&bHasDepth](int32 PositionIndex, const TArray<TArray<float>>& FaceDepths)
+	{
+		for (const TArray<float>& Depths : FaceDepths)
+		{
+			for (float Depth : Depths)
+			{
+				bHasDepth |= Depth > 1.0f;
+			}
+		}
+	});
+	DestroyDepthPrepassCamera(CubeCamera);
+	return bHasDepth;
+}
+
+bool FSeuratModule::MeasureCornerWeights(ASceneCaptureSeurat* InCaptureCamera, TArray<float>& OutCornerWeights)
+{
+	TArray<FVector> Corners;
+	for (int32 Corner = 0; Corner < kNumHeadboxCorners; ++Corner)
+	{
+		Corners.Add(GetHeadboxCorner(Corner, InCaptureCamera->HeadboxSize, InCaptureCamera->GetTransform()));
+	}
+	USceneCaptureComponentCube* CubeCamera = CreateDepthPrepassCamera(InCaptureCamera);
+	TArray<float> Scores;
+	const bool bRendered = RenderDepthCubes(CubeCamera, Corners, [&Scores](int32 Corner, const TArray<TArray<float>>& FaceDepths)
+	{
+		float Score = 0.0f;
+		for (const TArray<float>& Depths : FaceDepths)
+		{
+			Score += EstimateDisocclusion(Depths, kPrepassResolution, kPrepassResolution, kCornerMinDepth);
+		}
+		Scores.Add(Score);
+	});
+	DestroyDepthPrepassCamera(CubeCamera);
+	if (!bRendered)
+	{
+		return false;
+	}
+
+	// Weights are relative to their mean and rounded, so they and the settings
+	// hash stay the same when the unchanged scene is measured again.
+	float MeanScore = 0.0f;
+	for (float Score : Scores)
+	{
+		MeanScore += Score / Scores.Num();
+	}
+	OutCornerWeights.Empty(kNumHeadboxCorners);
+	for (float Score : Scores)
+	{
+		const float Weight = kUniformSampleDensity + (1.0f - kUniformSampleDensity) * (MeanScore > 0.0f ? Score / MeanScore : 1.0f);
+		OutCornerWeights.Add(FMath::RoundToFloat(Weight * 8.0f) / 8.0f);
+	}
+	UE_LOG(Seurat, Log, TEXT("Adaptive sample weights of the headbox corners: %s."), *FString::JoinBy(OutCornerWeights, TEXT(", "), [](float Weight) { return FString::SanitizeFloat(Weight); }));
+	return true;
+}
+
+bool FSeuratModule::CullFaces(int32 Resolution)
+{
+	USceneCaptureComponentCube* CubeCamera = CreateDepthPrepassCamera(ColorCameraActor.Get());
+	TArray<FSeuratFaceDepthStats> FaceStats;
+	FaceStats.Reserve(Samples.Num() * kNumCubeSides);
+	const float SkyDepth = ColorCameraActor->SkyDepth;
+	const bool bRendered = RenderDepthCubes(CubeCamera, Samples, [&FaceStats, SkyDepth](int32 SampleIndex, const TArray<TArray<float>>& FaceDepths)
+	{
+		for (const TArray<float>& Depths : FaceDepths)
+		{
+			FaceStats.Add(ComputeSeuratFaceDepthStats(Depths, SkyDepth));
+		}
+	});
+	DestroyDepthPrepassCamera(CubeCamera);
+	if (!bRendered)
+	{
+		return false;
+	}
+
+	FSeuratFaceCullSettings Settings;
+	Settings.MinGeometryFraction = ColorCameraActor->CullMinGeometryFraction;
+	Settings.MaxParallaxPixels = ColorCameraActor->CullMaxParallaxPixels;
+	Settings.Resolution = Resolution;
+	CullSeuratFaces(Samples, kNumCubeSides, FaceStats, Settings, FaceCulls);
+
+	int32 NumEmpty = 0;
+	int32 NumRedundant = 0;
+	for (ESeuratFaceCull Cull : FaceCulls)
+	{
+		NumEmpty += Cull == ESeuratFaceCull::Empty ? 1 : 0;
+		NumRedundant += Cull == ESeuratFaceCull::Redundant ? 1 : 0;
+	}
+	UE_LOG(Seurat, Log, TEXT("Culled %d empty and %d redundant of %d faces."), NumEmpty, NumRedundant, FaceCulls.Num());
+	return true;
+}
+
+void FSeuratModule::CreateCapturePool(int32 PoolSize, bool bCubeCapture)
+{
+	if (bCubeCapture)
+	{
+		for (int32 PoolIndex = 0; PoolIndex < PoolSize; ++PoolIndex)
+		{
+			USceneCaptureComponentCube* CubeCamera = NewObject<USceneCaptureComponentCube>(ColorCameraActor.Get(), NAME_None, RF_Transient);
+			CubeCamera->bCaptureEveryFrame = false;
+			CubeCamera->bCaptureOnMovement = false;
+			CubeCamera->CaptureSource = ESceneCaptureSource::SCS_SceneColorSceneDepth;
+			CubeCamera->ShowFlags = ColorCamera->ShowFlags;
+			CubeCamera->RegisterComponent();
+			CubeCameras.Add(CubeCamera);
+		}
+		return;
+	}
+
+	// The actor's own component is moved with the actor, as it always has been;
+	// the transient ones are unattached and placed in world space directly.
+	ColorCameras.Add(ColorCamera);
+	for (int32 PoolIndex = 1; PoolIndex < PoolSize; ++PoolIndex)
+	{
+		USceneCaptureComponent2D* Camera = NewObject<USceneCaptureComponent2D>(ColorCameraActor.Get(), NAME_None, RF_Transient);
+		Camera->bCaptureEveryFrame = false;
+		Camera->bCaptureOnMovement = false;
+		Camera->CaptureSource = ColorCamera->CaptureSource;
+		Camera->FOVAngle = ColorCamera->FOVAngle;
+		Camera->ShowFlags = ColorCamera->ShowFlags;
+		Camera->PostProcessSettings = ColorCamera->PostProcessSettings;
+		Camera->PostProcessBlendWeight = ColorCamera->PostProcessBlendWeight;
+		Camera->RegisterComponent();
+		ColorCameras.Add(Camera);
+	}
+}
+
+void FSeuratModule::ReleaseCapturePool()
+{
+	for (USceneCaptureComponentCube* CubeCamera : CubeCameras)
+	{
+		if (CubeCamera != nullptr && !CubeCamera->IsPendingKill())
+		{
+			CubeCamera->TextureTarget = nullptr;
+			CubeCamera->DestroyComponent();
+		}
+	}
+	CubeCameras.Empty();
+
+	for (USceneCaptureComponent2D* Camera : ColorCameras)
+	{
+		if (Camera == nullptr || Camera->IsPendingKill())
+		{
+			continue;
+		}
+		if (Camera == ColorCamera)
+		{
+			// Tiled views leave the actor's component with the projection of a tile.
+			Camera->bUseCustomProjectionMatrix = false;
+			continue;
+		}
+		Camera->TextureTarget = nullptr;
+		Camera->DestroyComponent();
+	}
+	ColorCameras.Empty();
+}
+
+SeuratView FSeuratModule::Capture(USceneCaptureComponent2D* Camera, FRotator Orientation, FVector Position, int32 Resolution)
 {
 	// Setup the camera.
-	ColorCameraActor->SetActorLocation(Position);
-	ColorCameraActor->SetActorRotation(Orientation);
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SeuratPositionCamera);
+		if (Camera == ColorCamera)
+		{
+			ColorCameraActor->SetActorLocation(Position);
+			ColorCameraActor->SetActorRotation(Orientation);
+		}
+		else
+		{
+			Camera->SetWorldLocationAndRotation(Position, Orientation);
+		}
+	}
 
 	// Note that if bCaptureEveryFrame is true and the game is not paused by any means,
 	// then this function call is redundant. However this is intentional since there are
@@ -426,29 +1314,25 @@ TSharedPtr<FJsonObject> FSeuratModule::Capture(FRotator Orientation, FVector Pos
 	// work and it would rely on these calls to capture properly. Also these calls are
 	// considered thread safe since they would resolve any CaptureSceneDeferred() before
 	// enqueue this CaptureScene() command.
-	ColorCamera->CaptureScene();
-
-	int32 InResolution = static_cast<int32>(ColorCameraActor->Resolution);
-	int32 Resolution = InResolution == 13 ? 1536 : FGenericPlatformMath::Pow(2, InResolution);
-
-	// Note, this matrix won't necessarily match Unreal's projection matrix. It
-	// doesn't matter in this case, because the Unreal plug captures eye space Z,
-	// so it doesn't need to decode from window space. However, the matrix informs
-	// Seurat of the near clip plane, and that the far clip is infinite. This also
-	// allows Seurat to do some window space operations on the captured points.
-	// This matrix is for a 90 degree frustum, infinite Z.
-	float C = -1.0f;
-	float D = -2 * GNearClippingPlane;
-	FMatrix ClipFromEye = FMatrix(
-		FPlane{ 1, 0, 0, 0 },
-		FPlane{ 0, 1, 0, 0 },
-		FPlane{ 0, 0, C, C },
-		FPlane{ 0, 0, D, 0 });
-	// This camera matrix stores this sample location's transformation, as opposed
-	// to the reference camera transform stored in
-	// WorldFromReferenceCameraMatrixSeurat.
-	FMatrix WorldFromEyeSampleCameraUnreal = ColorCameraActor->GetTransform().ToMatrixNoScale();
+	if (bCanRender)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SeuratCaptureScene);
+		Camera->CaptureScene();
+	}
+
+	if (Camera == ColorCamera)
+	{
+		return MakeView(ColorCameraActor->GetTransform().ToMatrixNoScale(), Resolution);
+	}
+	return MakeView(Camera->GetComponentTransform().ToMatrixNoScale(), Resolution);
+}
 
+SeuratView FSeuratModule::MakeView(const FMatrix& WorldFromEyeSampleCameraUnreal, int32 Resolution)
+{
+	FMatrix ClipFromEye = SeuratClipFromEyeMatrix(GNearClippingPlane);
+	// WorldFromEyeSampleCameraUnreal stores this sample location's
+	// transformation, as opposed to the reference camera transform stored in
+	// WorldFromReferenceCameraMatrixSeurat.
 	const FMatrix WorldFromEyeSeurat = SeuratMatrixFromUnrealMatrix(
 		WorldFromEyeSampleCameraUnreal);
 	// This line has two operations. First, inverting the world-from-eye matrix
@@ -478,33 +1362,122 @@ TSharedPtr<FJsonObject> FSeuratModule::Capture(FRotator Orientation, FVector Pos
 	MyView.DepthImageFile.Color.Channel1 = "G";
 	MyView.DepthImageFile.Color.Channel2 = "B";
 	MyView.DepthImageFile.Color.ChannelAlpha = "CONSTANT_ONE";
-	MyView.DepthImageFile.Depth.Path = BaseImageName + "_ColorDepth.exr";
-	MyView.DepthImageFile.Depth.Channel0 = "A";
+	if (DepthEncoding == ECaptureDepthEncoding::Lossless)
+	{
+		MyView.DepthImageFile.Depth.Path = BaseImageName + TEXT("_ColorDepth.") + SEURAT_DEPTH_EXTENSION;
+		MyView.DepthImageFile.Depth.Channel0 = "Z";
+	}
+	else
+	{
+		MyView.DepthImageFile.Depth.Path = BaseImageName + "_ColorDepth.exr";
+		MyView.DepthImageFile.Depth.Channel0 = "A";
+	}
 
-	return MyView.ToJson();
+	return MyView;
 }
 
-void FSeuratModule::WriteImage(UTextureRenderTarget2D* InRenderTarget, FString Filename, bool bClearAlpha)
+bool FSeuratModule::WriteImage(FSeuratReadbackImage& Image, FIntPoint Size)
 {
-	FTextureRenderTargetResource* RTResource = InRenderTarget->GameThread_GetRenderTargetResource();
-
-	// We're reading back depth in centimeters from alpha, and linear lighting.
-	const ERangeCompressionMode kDontRangeCompress = RCM_MinMax;
-	FReadSurfaceDataFlags ReadPixelFlags(kDontRangeCompress);
-	// We always want linear output.
-	ReadPixelFlags.SetLinearToGamma(false);
-
-	TArray<FLinearColor> OutBMP;
-	RTResource->ReadLinearColorPixels(OutBMP, ReadPixelFlags);
+	SCOPE_CYCLE_COUNTER(STAT_SeuratWriteImage);
+	// Images of culled sides have no file.
+	if (Image.Filename.IsEmpty())
+	{
+		PixelBufferPool.Release(MoveTemp(Image.Pixels));
+		return true;
+	}
+	// Apply back-pressure: keep the pixels in the readback ring until the
+	// writers have room, which in turn stalls further captures.
+	if (!ImageWriter.CanAccept(Image.Pixels.GetAllocatedSize()))
+	{
+		return false;
+	}
+	Report.FindOrAddView(FPaths::GetCleanFilename(Image.Filename)).ReadbackSeconds += Image.CompleteTime - Image.SubmitTime;
+
+	FSeuratImageWriteJob Job;
+	Job.Filename = Image.Filename;
+	Job.Tag = Image.Tag;
+	Job.Size = Size;
+	Job.Pixels = MoveTemp(Image.Pixels);
+	// The tag is the sample index, which gives the size of the whole view.
+	const int32 Resolution = SampleResolutions[Image.Tag];
+	const int32 TilesPerAxis = GetTilesPerAxis(Resolution, MaxTileResolution);
+	if (TilesPerAxis > 1)
+	{
+		Job.NumTiles = TilesPerAxis * TilesPerAxis;
+		Job.ImageSize = FIntPoint(Resolution, Resolution);
+		Job.TileOffset = GetTileOffset(Image.TileIndex, TilesPerAxis, Size.X);
+	}
+	ImageWriter.Enqueue(MoveTemp(Job));
+	return true;
+}
 
-	FIntRect SourceRect;
+static void FindPackLocation(const FSeuratPackWriter& Pack, const FString& Path, PackLocation& OutLocation)
+{
+	FSeuratPackEntry Entry;
+	if (Pack.FindEntry(Path, Entry))
+	{
+		OutLocation.Offset = Entry.Offset;
+		OutLocation.Size = Entry.Size;
+	}
+}
 
-	FIntPoint DestSize(InRenderTarget->GetSurfaceWidth(), InRenderTarget->GetSurfaceHeight());
+void FSeuratModule::AppendCompletedViewGroups()
+{
+	FSeuratImageWriteResult Result;
+	while (ImageWriter.DequeueResult(Result))
+	{
+		FSeuratPendingViewGroup* ViewGroup = PendingViewGroups.Find(Result.Tag);
+		if (ViewGroup != nullptr)
+		{
+			--ViewGroup->NumPendingImages;
+		}
+		if (Result.bSucceeded)
+		{
+			Checkpoint.MarkImageComplete(Result.Filename, Result.FileSizeBytes);
+			ViewBounds.SetDepthRange(FPaths::GetCleanFilename(Result.Filename), MakeSeuratViewDepthRange(Result.MinDepth, Result.MaxDepth, ColorCameraActor->SkyDepth));
+		}
+		FSeuratViewTiming& Timing = Report.FindOrAddView(FPaths::GetCleanFilename(Result.Filename));
+		Timing.EncodeSeconds = Result.EncodeSeconds;
+		Timing.WriteSeconds = Result.WriteSeconds;
+		Timing.BytesWritten = Result.FileSizeBytes + Result.DepthFileSizeBytes;
+	}
 
-	FString ResultPath;
-	FHighResScreenshotConfig& HighResScreenshotConfig = GetHighResScreenshotConfig();
-	HighResScreenshotConfig.bCaptureHDR = true;
-	HighResScreenshotConfig.SaveImage(Filename, OutBMP, DestSize);
+	// Append groups in sample order, so the manifest matches the order of a
+	// capture that builds all view groups at once.
+	while (true)
+	{
+		FSeuratPendingViewGroup* ViewGroup = PendingViewGroups.Find(NextViewGroup);
+		if (ViewGroup == nullptr || ViewGroup->NumViews < GetNumViewsInRange(NextViewGroup) || ViewGroup->NumPendingImages > 0)
+		{
+			break;
+		}
+		TArray<SeuratView> CapturedViews;
+		for (int32 Side = 0; Side < ViewGroup->Views.Num(); ++Side)
+		{
+			if ((ViewGroup->CulledSides & (1u << Side)) == 0 && IsViewInRange(NextViewGroup, Side))
+			{
+				CapturedViews.Add(ViewGroup->Views[Side]);
+			}
+		}
+		if (Pack.IsOpen())
+		{
+			for (SeuratView& View : CapturedViews)
+			{
+				FindPackLocation(Pack, View.DepthImageFile.Color.Path, View.DepthImageFile.Color.Pack);
+				FindPackLocation(Pack, View.DepthImageFile.Depth.Path, View.DepthImageFile.Depth.Pack);
+			}
+		}
+		if (!Manifest.AppendViewGroup(CapturedViews, ViewGroup->CulledFaces))
+		{
+			UE_LOG(Seurat, Error, TEXT("Failed to append view group %d to the capture manifest."), NextViewGroup);
+		}
+		if (bBinaryManifest)
+		{
+			BinaryManifest.AddViewGroup(CapturedViews, ViewGroup->CulledFaces);
+		}
+		PendingViewGroups.Remove(NextViewGroup);
+		++NextViewGroup;
+	}
 }
 
 bool FSeuratModule::SaveStringTextToFile(FString SaveDirectory, FString FileName, FString SaveText, bool AllowOverWriting)
@@ -544,15 +1517,6 @@ bool FSeuratModule::SaveStringTextToFile(FString SaveDirectory, FString FileName
 	return FFileHelper::SaveStringToFile(SaveText, *SaveDirectory);
 }
 
-void FSeuratModule::GenerateJson(TSharedPtr<FJsonObject> JsonObject, FString ExportPath)
-{
-	FString OutputString;
-	TSharedRef< TJsonWriter< TCHAR, TPrettyJsonPrintPolicy< TCHAR > > > Writer = TJsonWriterFactory< TCHAR, TPrettyJsonPrintPolicy< TCHAR > >::Create(&OutputString);
-	FJsonSerializer::Serialize(JsonObject.ToSharedRef(), Writer);
-	if (!SaveStringTextToFile(ExportPath, "manifest.json", OutputString, true))
-		UE_LOG(Seurat, Error, TEXT("Saving json to file failed"));
-}
-
 #undef LOCTEXT_NAMESPACE
 
 DEFINE_LOG_CATEGORY(Seurat);
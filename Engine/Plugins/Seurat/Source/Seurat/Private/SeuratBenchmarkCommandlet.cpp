@@ -0,0 +1,62 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratBenchmarkCommandlet.h"
+#include "SeuratBenchmark.h"
+#include "SeuratExrWriter.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+USeuratBenchmarkCommandlet::USeuratBenchmarkCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+// Loads the depth of the capture images in |Directory| that keep it in the
+// EXR. Encoded depth images are loaded by the benchmark suite.
+static void LoadExrDepthImages(const FString& Directory, TArray<FSeuratBenchmarkDepthImage>& OutImages)
+{
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *(Directory / TEXT("*_ColorDepth.exr")), true, false);
+	Filenames.Sort();
+	for (const FString& Filename : Filenames)
+	{
+		FSeuratBenchmarkDepthImage Image;
+		FIntPoint Size;
+		if (!ReadSeuratExrDepth(Directory / Filename, Image.Depths, Size))
+		{
+			continue;
+		}
+		Image.Name = FPaths::GetBaseFilename(Filename);
+		Image.Width = Size.X;
+		Image.Height = Size.Y;
+		OutImages.Add(MoveTemp(Image));
+	}
+}
+
+int32 USeuratBenchmarkCommandlet::Main(const FString& Params)
+{
+	FSeuratBenchmarkOptions Options;
+	ParseSeuratBenchmarkOptions(*Params, Options);
+	if (!Options.DepthImageDirectory.IsEmpty())
+	{
+		LoadExrDepthImages(Options.DepthImageDirectory, Options.DepthImages);
+	}
+	return RunSeuratBenchmarkSuite(Options);
+}
@@ -0,0 +1,44 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SeuratBenchmarkCommandlet.generated.h"
+
+// Measures the throughput of the engine independent capture code: headbox
+// sample generation, matrix conversion, manifest serialization and depth
+// coding. Runs without a map or rendering, so results are comparable across
+// machines and platforms. Depth coding runs on synthetic depth maps and,
+// optionally, on the depth of the capture images in a directory. Returns
+// non-zero if a benchmark computes a wrong result.
+//
+// The benchmarks live in SeuratCore; without the editor, run them with the
+// Seurat.Benchmark console command, which takes the same options.
+//
+// Usage:
+//   UE4Editor-Cmd <Project> -run=SeuratBenchmark [-Samples=256,65536]
+//     [-Views=1536,12288] [-Matrices=Count] [-MinTime=Seconds] [-Filter=Name]
+//     [-DepthSizes=1024,4096] [-DepthImages=CaptureDirectory]
+//     [-Output=Results.json]
+UCLASS()
+class USeuratBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	/** UCommandlet implementation */
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,228 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratCaptureCommandlet.h"
+#include "Seurat.h"
+#include "SceneCaptureSeurat.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "RenderingThread.h"
+
+// World time step of each capture tick. Time doesn't advance in the captured
+// scene, so this only matters for systems that tick regardless.
+static const float kCommandletDeltaSeconds = 1.0f / 30.0f;
+
+USeuratCaptureCommandlet::USeuratCaptureCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+static UWorld* LoadCaptureWorld(FString MapName)
+{
+	if (!FPackageName::IsValidLongPackageName(MapName))
+	{
+		FString LongPackageName;
+		if (!FPackageName::SearchForPackageOnDisk(MapName, &LongPackageName))
+		{
+			UE_LOG(Seurat, Error, TEXT("Cannot find map %s."), *MapName);
+			return nullptr;
+		}
+		MapName = LongPackageName;
+	}
+
+	UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = Package != nullptr ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (World == nullptr)
+	{
+		UE_LOG(Seurat, Error, TEXT("Cannot load map %s."), *MapName);
+		return nullptr;
+	}
+
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues().ShouldSimulatePhysics(false).EnableTraceCollision(false));
+	}
+	World->LoadSecondaryLevels(true);
+	World->UpdateWorldComponents(true, false);
+	FlushRenderingCommands();
+	return World;
+}
+
+static bool ShouldCapture(ASceneCaptureSeurat* Actor, const TArray<FString>& ActorNames, const FName& Tag)
+{
+	if (ActorNames.Num() == 0 && Tag.IsNone())
+	{
+		return true;
+	}
+	if (!Tag.IsNone() && Actor->ActorHasTag(Tag))
+	{
+		return true;
+	}
+	return ActorNames.Contains(Actor->GetName()) || ActorNames.Contains(Actor->GetActorLabel());
+}
+
+// Parses "Index/Count" of -Shard.
+static bool ParseShard(const FString& Shard, int32& OutIndex, int32& OutCount)
+{
+	FString Index;
+	FString Count;
+	if (!Shard.Split(TEXT("/"), &Index, &Count) || !Index.IsNumeric() || !Count.IsNumeric())
+	{
+		return false;
+	}
+	OutIndex = FCString::Atoi(*Index);
+	OutCount = FCString::Atoi(*Count);
+	return OutCount > 0 && OutIndex >= 0 && OutIndex < OutCount;
+}
+
+int32 USeuratCaptureCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	const FString MapName = ParamVals.FindRef(TEXT("Map"));
+	if (MapName.IsEmpty())
+	{
+		UE_LOG(Seurat, Error, TEXT("Usage: -run=SeuratCapture -Map=<Map> -AllowCommandletRendering [-ManifestOnly] [-Actors=<Names>] [-Tag=<Tag>] [-OutputDir=<Path>] [-Timeout=<Seconds>] [-Shard=<Index>/<Count> | -FirstView=<View> -EndView=<View>]"));
+		return 1;
+	}
+	// Commandlets only render with -AllowCommandletRendering. Without rendering
+	// a capture only writes its manifest and still succeeds, so that must be
+	// asked for rather than happen on a misconfigured build machine.
+	const bool bManifestOnly = Switches.Contains(TEXT("ManifestOnly")) || FParse::Param(FCommandLine::Get(), TEXT("nullrhi"));
+	if (!FApp::CanEverRender() && !bManifestOnly)
+	{
+		UE_LOG(Seurat, Error, TEXT("Cannot render. Run with -AllowCommandletRendering to capture images, or with -ManifestOnly or -nullrhi to only write manifests."));
+		return 1;
+	}
+	if (FApp::CanEverRender() && Switches.Contains(TEXT("ManifestOnly")))
+	{
+		UE_LOG(Seurat, Warning, TEXT("-ManifestOnly has no effect when rendering is available; images are captured."));
+	}
+	int32 ShardIndex = 0;
+	int32 ShardCount = 0;
+	if (ParamVals.Contains(TEXT("Shard")) && !ParseShard(ParamVals.FindRef(TEXT("Shard")), ShardIndex, ShardCount))
+	{
+		UE_LOG(Seurat, Error, TEXT("-Shard must be <Index>/<Count>, with Index less than Count."));
+		return 1;
+	}
+
+	TArray<FString> ActorNames;
+	ParamVals.FindRef(TEXT("Actors")).ParseIntoArray(ActorNames, TEXT(","), true);
+	const FString TagName = ParamVals.FindRef(TEXT("Tag"));
+	const FName Tag = TagName.IsEmpty() ? NAME_None : FName(*TagName);
+	const FString OutputDir = ParamVals.FindRef(TEXT("OutputDir"));
+	const double TimeoutSeconds = FCString::Atod(*ParamVals.FindRef(TEXT("Timeout")));
+
+	UWorld* World = LoadCaptureWorld(MapName);
+	if (World == nullptr)
+	{
+		return 1;
+	}
+
+	TArray<ASceneCaptureSeurat*> CaptureActors;
+	for (TActorIterator<ASceneCaptureSeurat> It(World); It; ++It)
+	{
+		if (ShouldCapture(*It, ActorNames, Tag))
+		{
+			CaptureActors.Add(*It);
+		}
+	}
+	if (CaptureActors.Num() == 0)
+	{
+		UE_LOG(Seurat, Error, TEXT("No Seurat capture actors to capture in %s."), *MapName);
+		World->RemoveFromRoot();
+		return 1;
+	}
+
+	FSeuratModule& SeuratModule = FModuleManager::LoadModuleChecked<FSeuratModule>("Seurat");
+	int32 NumFailed = 0;
+	for (ASceneCaptureSeurat* Actor : CaptureActors)
+	{
+		FSeuratCaptureOptions Options;
+		Options.bUnattended = true;
+		if (ShardCount > 0)
+		{
+			// Shards split between samples, so they suit every cube capture mode.
+			const int32 NumSamples = SeuratModule.GetNumCaptureViews(Actor) / 6;
+			Options.FirstView = NumSamples * ShardIndex / ShardCount * 6;
+			Options.EndView = NumSamples * (ShardIndex + 1) / ShardCount * 6;
+		}
+		else
+		{
+			if (ParamVals.Contains(TEXT("FirstView")))
+			{
+				Options.FirstView = FCString::Atoi(*ParamVals.FindRef(TEXT("FirstView")));
+			}
+			if (ParamVals.Contains(TEXT("EndView")))
+			{
+				Options.EndView = FCString::Atoi(*ParamVals.FindRef(TEXT("EndView")));
+			}
+		}
+		// Each actor gets its own directory, so captures don't overwrite each
+		// other's images and manifest.
+		const FString BaseDir = OutputDir.IsEmpty() ? FSeuratModule::GetDefaultOutputDirectory() : OutputDir;
+		Options.OutputDirectory = FPaths::ConvertRelativePathToFull(CaptureActors.Num() > 1 ? BaseDir / Actor->GetName() : BaseDir);
+
+		UE_LOG(Seurat, Display, TEXT("Capturing %s."), *Actor->GetName());
+		if (!SeuratModule.BeginCapture(Actor, Options))
+		{
+			++NumFailed;
+			continue;
+		}
+
+		// The module advances the capture from the world tick.
+		const double StartTime = FPlatformTime::Seconds();
+		while (SeuratModule.IsCapturing())
+		{
+			if (TimeoutSeconds > 0.0 && FPlatformTime::Seconds() - StartTime > TimeoutSeconds)
+			{
+				UE_LOG(Seurat, Error, TEXT("Capture of %s timed out."), *Actor->GetName());
+				SeuratModule.CancelCapture();
+				break;
+			}
+			World->Tick(LEVELTICK_All, kCommandletDeltaSeconds);
+			FTicker::GetCoreTicker().Tick(kCommandletDeltaSeconds);
+			++GFrameCounter;
+			FPlatformProcess::Sleep(0.0f);
+		}
+
+		if (!SeuratModule.DidLastCaptureSucceed())
+		{
+			UE_LOG(Seurat, Error, TEXT("Capture of %s failed."), *Actor->GetName());
+			++NumFailed;
+		}
+	}
+
+	FlushRenderingCommands();
+	World->RemoveFromRoot();
+
+	UE_LOG(Seurat, Display, TEXT("Captured %d of %d Seurat capture actors."), CaptureActors.Num() - NumFailed, CaptureActors.Num());
+	return NumFailed == 0 ? 0 : 1;
+}
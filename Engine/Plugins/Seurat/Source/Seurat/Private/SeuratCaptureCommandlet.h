@@ -0,0 +1,50 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SeuratCaptureCommandlet.generated.h"
+
+// Captures ASceneCaptureSeurat actors of a map without the editor UI, e.g. on
+// render farm nodes. Returns a non-zero exit code if any capture fails.
+//
+// Usage:
+//   UE4Editor-Cmd <Project> -run=SeuratCapture -Map=/Game/Maps/MyMap
+//     -AllowCommandletRendering [-ManifestOnly] [-Actors=Name1,Name2] [-Tag=Tag] [-OutputDir=Path] [-Timeout=Seconds]
+//     [-Shard=Index/Count | -FirstView=View -EndView=View]
+//
+// Without -Actors or -Tag, every Seurat capture actor in the map is captured.
+// Actors match by object name or editor label. With more than one actor, each
+// capture is written to a subdirectory named after the actor, in OutputDir or
+// in the default output directory, Intermediate/SeuratCapture.
+// Commandlets only render with -AllowCommandletRendering; without it the
+// commandlet fails rather than capture no images. Running with -ManifestOnly
+// instead, or with -nullrhi, accepts that rendering is skipped and only writes
+// the manifests.
+//
+// -Shard captures one of Count parts of each capture, split between samples,
+// and -FirstView and -EndView capture a range of views. Each part needs its own
+// OutputDir. Merge the manifests of the parts with the SeuratManifest
+// commandlet and gather their images next to the merged manifest.
+UCLASS()
+class USeuratCaptureCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	/** UCommandlet implementation */
+	virtual int32 Main(const FString& Params) override;
+};
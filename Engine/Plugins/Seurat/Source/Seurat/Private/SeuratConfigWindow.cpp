@@ -14,6 +14,9 @@
 */
 
 #include "SeuratConfigWindow.h"
+#include "Seurat.h"
+#include "Editor.h"
+#include "Engine/Selection.h"
 
 #define LOCTEXT_NAMESPACE "FSeuratModule"
 
@@ -47,6 +50,17 @@ void SSeuratConfigWindow::Construct(const FArguments& InArgs, ASceneCaptureSeura
 			.VAlign(VAlign_Center)
 			.OnClicked(this, &SSeuratConfigWindow::Capture)
 		]
+		+ SVerticalBox::Slot()
+		.Padding(2.0f)
+		.AutoHeight()
+		[
+			SNew(SButton)
+			.Text(LOCTEXT("Recapture Selected", "Recapture Selected"))
+			.ToolTipText(LOCTEXT("Recapture Selected Tooltip", "Updates the last capture by rendering only the views that can see the selected actors. Views that saw a moved actor at its old location are not updated."))
+			.HAlign(HAlign_Center)
+			.VAlign(VAlign_Center)
+			.OnClicked(this, &SSeuratConfigWindow::RecaptureSelected)
+		]
 	];
 }
 
@@ -60,4 +74,30 @@ FReply SSeuratConfigWindow::Capture()
 	return FReply::Handled();
 }
 
+FReply SSeuratConfigWindow::RecaptureSelected()
+{
+	FSeuratCaptureOptions Options;
+	Options.bOnlyChangedViews = true;
+	for (FSelectionIterator It(GEditor->GetSelectedActorIterator()); It; ++It)
+	{
+		AActor* Actor = Cast<AActor>(*It);
+		if (Actor != nullptr && Actor != Owner)
+		{
+			Options.ChangedBounds.Add(Actor->GetComponentsBoundingBox(true));
+		}
+	}
+	if (Options.ChangedBounds.Num() == 0)
+	{
+		FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("No Changed Actors", "Select the actors that changed since the last capture."));
+		return FReply::Handled();
+	}
+
+	FSeuratModule* SeuratModule = FModuleManager::GetModulePtr<FSeuratModule>("Seurat");
+	if (SeuratModule != nullptr)
+	{
+		SeuratModule->BeginCapture(Owner, Options);
+	}
+	return FReply::Handled();
+}
+
 #undef LOCTEXT_NAMESPACE
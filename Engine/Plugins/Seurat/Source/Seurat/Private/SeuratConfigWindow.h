@@ -33,4 +33,6 @@ public:
 
 private:
 	FReply Capture();
+	// Updates the last capture for changes to the selected actors.
+	FReply RecaptureSelected();
 };
\ No newline at end of file
@@ -0,0 +1,281 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratExrWriter.h"
+#include "Seurat.h"
+#include "HAL/PlatformFilemanager.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "ThirdParty/openexr/Deploy/include/ImfIO.h"
+#include "ThirdParty/openexr/Deploy/include/ImfChannelList.h"
+#include "ThirdParty/openexr/Deploy/include/ImfFrameBuffer.h"
+#include "ThirdParty/openexr/Deploy/include/ImfHeader.h"
+#include "ThirdParty/openexr/Deploy/include/ImfInputFile.h"
+#include "ThirdParty/openexr/Deploy/include/ImfOutputFile.h"
+#include "ThirdParty/openexr/Deploy/include/ImfTiledOutputFile.h"
+THIRD_PARTY_INCLUDES_END
+
+// Collects the encoded file in memory, so it is written to disk through the
+// engine's file system like the rest of the capture output.
+class FSeuratExrMemoryStream : public Imf::OStream
+{
+public:
+	FSeuratExrMemoryStream(TArray<uint8>& InData) : Imf::OStream(""), Data(InData), Position(0) {}
+
+	virtual void write(const char Chars[], int NumChars) override
+	{
+		const int64 End = Position + NumChars;
+		if (End > Data.Num())
+		{
+			Data.AddUninitialized(End - Data.Num());
+		}
+		FMemory::Memcpy(Data.GetData() + Position, Chars, NumChars);
+		Position = End;
+	}
+
+	virtual Imf::Int64 tellp() override
+	{
+		return Position;
+	}
+
+	virtual void seekp(Imf::Int64 InPosition) override
+	{
+		Position = InPosition;
+	}
+
+private:
+	TArray<uint8>& Data;
+	int64 Position;
+};
+
+static Imf::Compression GetExrCompression(ECaptureExrCompression Compression)
+{
+	switch (Compression)
+	{
+	case ECaptureExrCompression::None:
+		return Imf::NO_COMPRESSION;
+	case ECaptureExrCompression::Piz:
+		return Imf::PIZ_COMPRESSION;
+	case ECaptureExrCompression::Dwaa:
+		return Imf::DWAA_COMPRESSION;
+	case ECaptureExrCompression::Zip:
+	default:
+		return Imf::ZIP_COMPRESSION;
+	}
+}
+
+// Adds the channels of a capture image to |Header|.
+static void AddExrChannels(Imf::Header& Header, const FSeuratExrSettings& Settings)
+{
+	Header.compression() = GetExrCompression(Settings.Compression);
+	Header.channels().insert("R", Imf::Channel(Imf::HALF));
+	Header.channels().insert("G", Imf::Channel(Imf::HALF));
+	Header.channels().insert("B", Imf::Channel(Imf::HALF));
+	if (Settings.DepthEncoding == ECaptureDepthEncoding::Exr)
+	{
+		Header.channels().insert("A", Imf::Channel(Settings.DepthPrecision == ECaptureDepthPrecision::Half ? Imf::HALF : Imf::FLOAT));
+	}
+}
+
+// Points the channels of a capture image at |Pixels|, rows of |Width| pixels
+// whose first pixel is pixel |Origin| of the image. Full precision depth is
+// converted into |FloatDepth|, which must outlive the frame buffer.
+static void AddExrSlices(Imf::FrameBuffer& FrameBuffer, const TArray<FFloat16Color>& Pixels, int32 Width, FIntPoint Origin, const FSeuratExrSettings& Settings, TArray<float>& FloatDepth)
+{
+	// OpenEXR addresses pixels by their image coordinates, so the slice bases
+	// are offset to put the origin at the first pixel. FFloat16 has the same
+	// layout as OpenEXR's half, so half channels are read straight from the
+	// pixels.
+	const size_t StrideX = sizeof(FFloat16Color);
+	const size_t StrideY = StrideX * Width;
+	char* PixelData = const_cast<char*>(reinterpret_cast<const char*>(Pixels.GetData())) - Origin.Y * StrideY - Origin.X * StrideX;
+	FrameBuffer.insert("R", Imf::Slice(Imf::HALF, PixelData + STRUCT_OFFSET(FFloat16Color, R), StrideX, StrideY));
+	FrameBuffer.insert("G", Imf::Slice(Imf::HALF, PixelData + STRUCT_OFFSET(FFloat16Color, G), StrideX, StrideY));
+	FrameBuffer.insert("B", Imf::Slice(Imf::HALF, PixelData + STRUCT_OFFSET(FFloat16Color, B), StrideX, StrideY));
+	if (Settings.DepthEncoding != ECaptureDepthEncoding::Exr)
+	{
+		return;
+	}
+
+	// Only full precision depth needs converting.
+	if (Settings.DepthPrecision == ECaptureDepthPrecision::Half)
+	{
+		FrameBuffer.insert("A", Imf::Slice(Imf::HALF, PixelData + STRUCT_OFFSET(FFloat16Color, A), StrideX, StrideY));
+		return;
+	}
+	FloatDepth.SetNumUninitialized(Pixels.Num());
+	for (int32 PixelIndex = 0; PixelIndex < Pixels.Num(); ++PixelIndex)
+	{
+		FloatDepth[PixelIndex] = Pixels[PixelIndex].A.GetFloat();
+	}
+	char* DepthData = reinterpret_cast<char*>(FloatDepth.GetData()) - (static_cast<int64>(Origin.Y) * Width + Origin.X) * sizeof(float);
+	FrameBuffer.insert("A", Imf::Slice(Imf::FLOAT, DepthData, sizeof(float), sizeof(float) * Width));
+}
+
+bool EncodeSeuratExr(const TArray<FFloat16Color>& Pixels, FIntPoint Size, const FSeuratExrSettings& Settings, TArray<uint8>& OutData)
+{
+	check(Pixels.Num() == Size.X * Size.Y);
+	Imf::Header Header(Size.X, Size.Y);
+	AddExrChannels(Header, Settings);
+	Imf::FrameBuffer FrameBuffer;
+	TArray<float> FloatDepth;
+	AddExrSlices(FrameBuffer, Pixels, Size.X, FIntPoint(0, 0), Settings, FloatDepth);
+
+	OutData.Reset();
+	try
+	{
+		FSeuratExrMemoryStream Stream(OutData);
+		Imf::OutputFile File(Stream, Header);
+		File.setFrameBuffer(FrameBuffer);
+		File.writePixels(Size.Y);
+	}
+	catch (const std::exception& Exception)
+	{
+		UE_LOG(Seurat, Error, TEXT("Failed to encode capture image: %s"), UTF8_TO_TCHAR(Exception.what()));
+		return false;
+	}
+	return true;
+}
+
+// Writes an EXR file straight to disk. Tiled files seek back to write their
+// tile offsets when they are closed.
+class FSeuratExrFileStream : public Imf::OStream
+{
+public:
+	FSeuratExrFileStream(IFileHandle* InHandle) : Imf::OStream(""), Handle(InHandle), bFailed(false) {}
+
+	virtual void write(const char Chars[], int NumChars) override
+	{
+		bFailed |= !Handle->Write(reinterpret_cast<const uint8*>(Chars), NumChars);
+	}
+
+	virtual Imf::Int64 tellp() override
+	{
+		return Handle->Tell();
+	}
+
+	virtual void seekp(Imf::Int64 InPosition) override
+	{
+		bFailed |= !Handle->Seek(InPosition);
+	}
+
+	bool HasFailed() const { return bFailed; }
+
+private:
+	TUniquePtr<IFileHandle> Handle;
+	bool bFailed;
+};
+
+FSeuratTiledExrWriter::FSeuratTiledExrWriter() : TileSize(0, 0), NumTiles(0), NumTilesWritten(0)
+{
+}
+
+FSeuratTiledExrWriter::~FSeuratTiledExrWriter()
+{
+	Close();
+}
+
+bool FSeuratTiledExrWriter::Open(const FString& Filename, FIntPoint ImageSize, FIntPoint InTileSize, const FSeuratExrSettings& InSettings)
+{
+	Close();
+	IFileHandle* Handle = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*Filename);
+	if (Handle == nullptr)
+	{
+		return false;
+	}
+	Stream.Reset(new FSeuratExrFileStream(Handle));
+	Settings = InSettings;
+	TileSize = InTileSize;
+	NumTiles = FMath::DivideAndRoundUp(ImageSize.X, TileSize.X) * FMath::DivideAndRoundUp(ImageSize.Y, TileSize.Y);
+	NumTilesWritten = 0;
+
+	Imf::Header Header(ImageSize.X, ImageSize.Y);
+	AddExrChannels(Header, Settings);
+	Header.setTileDescription(Imf::TileDescription(TileSize.X, TileSize.Y, Imf::ONE_LEVEL));
+	// Tiles are written as they arrive rather than buffered until their turn.
+	Header.lineOrder() = Imf::RANDOM_Y;
+	try
+	{
+		File.Reset(new Imf::TiledOutputFile(*Stream, Header));
+	}
+	catch (const std::exception& Exception)
+	{
+		UE_LOG(Seurat, Error, TEXT("Failed to create capture image %s: %s"), *Filename, UTF8_TO_TCHAR(Exception.what()));
+		Stream.Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FSeuratTiledExrWriter::WriteTile(const TArray<FFloat16Color>& Pixels, FIntPoint TileOffset)
+{
+	check(IsOpen() && Pixels.Num() == TileSize.X * TileSize.Y);
+	Imf::FrameBuffer FrameBuffer;
+	TArray<float> FloatDepth;
+	AddExrSlices(FrameBuffer, Pixels, TileSize.X, TileOffset, Settings, FloatDepth);
+	try
+	{
+		File->setFrameBuffer(FrameBuffer);
+		File->writeTile(TileOffset.X / TileSize.X, TileOffset.Y / TileSize.Y);
+	}
+	catch (const std::exception& Exception)
+	{
+		UE_LOG(Seurat, Error, TEXT("Failed to write a tile of a capture image: %s"), UTF8_TO_TCHAR(Exception.what()));
+		return false;
+	}
+	++NumTilesWritten;
+	return !Stream->HasFailed();
+}
+
+bool FSeuratTiledExrWriter::Close()
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+	// Destroying the file writes the tile offsets.
+	File.Reset();
+	const bool bSucceeded = !Stream->HasFailed() && NumTilesWritten == NumTiles;
+	Stream.Reset();
+	return bSucceeded;
+}
+
+bool ReadSeuratExrDepth(const FString& Filename, TArray<float>& OutDepths, FIntPoint& OutSize)
+{
+	try
+	{
+		Imf::InputFile File(TCHAR_TO_UTF8(*Filename));
+		if (File.header().channels().findChannel("A") == nullptr)
+		{
+			return false;
+		}
+		const Imath::Box2i DataWindow = File.header().dataWindow();
+		OutSize = FIntPoint(DataWindow.max.x - DataWindow.min.x + 1, DataWindow.max.y - DataWindow.min.y + 1);
+		OutDepths.SetNumUninitialized(OutSize.X * OutSize.Y);
+		// The slice base is offset so that the data window starts at the first
+		// element.
+		char* Base = reinterpret_cast<char*>(OutDepths.GetData()) - (static_cast<int64>(DataWindow.min.y) * OutSize.X + DataWindow.min.x) * sizeof(float);
+		Imf::FrameBuffer FrameBuffer;
+		FrameBuffer.insert("A", Imf::Slice(Imf::FLOAT, Base, sizeof(float), sizeof(float) * OutSize.X));
+		File.setFrameBuffer(FrameBuffer);
+		File.readPixels(DataWindow.min.y, DataWindow.max.y);
+	}
+	catch (const std::exception& Exception)
+	{
+		UE_LOG(Seurat, Error, TEXT("Failed to read depth of %s: %s"), *Filename, UTF8_TO_TCHAR(Exception.what()));
+		return false;
+	}
+	return true;
+}
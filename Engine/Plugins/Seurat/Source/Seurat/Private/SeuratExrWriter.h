@@ -0,0 +1,74 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Float16Color.h"
+#include "SceneCaptureSeurat.h"
+
+namespace Imf
+{
+class TiledOutputFile;
+}
+class FSeuratExrFileStream;
+
+// Channel layout and compression of capture images.
+struct FSeuratExrSettings
+{
+	ECaptureExrCompression Compression;
+	ECaptureDepthPrecision DepthPrecision;
+	// The image has no depth channel unless depth is encoded as EXR.
+	ECaptureDepthEncoding DepthEncoding;
+
+	FSeuratExrSettings() : Compression(ECaptureExrCompression::Zip), DepthPrecision(ECaptureDepthPrecision::Float), DepthEncoding(ECaptureDepthEncoding::Exr) {}
+};
+
+// Encodes a capture image as OpenEXR. Color goes to half float R, G and B
+// channels; eye space depth, read from alpha, goes to channel A at the
+// configured precision. Thread safe.
+bool EncodeSeuratExr(const TArray<FFloat16Color>& Pixels, FIntPoint Size, const FSeuratExrSettings& Settings, TArray<uint8>& OutData);
+
+// Reads the depth channel A of an EXR image as floats. Returns false if the
+// file cannot be read or has no depth.
+bool ReadSeuratExrDepth(const FString& Filename, TArray<float>& OutDepths, FIntPoint& OutSize);
+
+// Writes a capture image that is rendered in tiles to a tiled EXR file, one
+// tile at a time as the tiles arrive, so the whole image is never in memory.
+// The channels are those of EncodeSeuratExr. Not thread safe.
+class FSeuratTiledExrWriter
+{
+public:
+	FSeuratTiledExrWriter();
+	~FSeuratTiledExrWriter();
+
+	// Creates an image of |ImageSize| pixels, stored in tiles of |InTileSize|.
+	bool Open(const FString& Filename, FIntPoint ImageSize, FIntPoint InTileSize, const FSeuratExrSettings& InSettings);
+	// Writes the tile whose first pixel is |TileOffset|, a multiple of the tile
+	// size. Pixels beyond the image are dropped. Tiles may come in any order.
+	bool WriteTile(const TArray<FFloat16Color>& Pixels, FIntPoint TileOffset);
+	// Finishes the file. Returns false if a tile is missing or a write failed.
+	bool Close();
+
+	bool IsOpen() const { return File.IsValid(); }
+
+private:
+	TUniquePtr<FSeuratExrFileStream> Stream;
+	TUniquePtr<Imf::TiledOutputFile> File;
+	FSeuratExrSettings Settings;
+	FIntPoint TileSize;
+	int32 NumTiles;
+	int32 NumTilesWritten;
+};
@@ -0,0 +1,311 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratImageWriter.h"
+#include "Seurat.h"
+#include "SeuratDepthCodec.h"
+#include "SeuratPack.h"
+#include "SeuratPixelBufferPool.h"
+#include "SeuratStats.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("Encode Image"), STAT_SeuratEncodeImage, STATGROUP_Seurat);
+DECLARE_CYCLE_STAT(TEXT("Save Image"), STAT_SeuratSaveImage, STATGROUP_Seurat);
+
+// How long an idle worker sleeps before checking whether it should exit.
+static const uint32 kWorkerWaitMilliseconds = 100;
+
+FSeuratImageWriter::FSeuratImageWriter() : WorkAvailable(nullptr), MemoryBudgetBytes(0), BufferPool(nullptr), Pack(nullptr)
+{
+}
+
+FSeuratImageWriter::~FSeuratImageWriter()
+{
+	Stop(true);
+}
+
+void FSeuratImageWriter::Start(int32 InNumThreads, int64 InMemoryBudgetBytes, const FSeuratExrSettings& InExrSettings, FSeuratPixelBufferPool& InBufferPool, FSeuratPackWriter* InPack)
+{
+	Stop(true);
+
+	MemoryBudgetBytes = InMemoryBudgetBytes;
+	ExrSettings = InExrSettings;
+	BufferPool = &InBufferPool;
+	Pack = InPack;
+	NumFailedWrites.Reset();
+	Results.Empty();
+	bStopping = false;
+	WorkAvailable = FPlatformProcess::GetSynchEventFromPool(false);
+
+	for (int32 ThreadIndex = 0; ThreadIndex < FMath::Max(InNumThreads, 1); ++ThreadIndex)
+	{
+		TUniquePtr<FWorker> Worker = MakeUnique<FWorker>(*this);
+		FString ThreadName = FString::Printf(TEXT("SeuratImageWriter%d"), ThreadIndex);
+		Threads.Add(FRunnableThread::Create(Worker.Get(), *ThreadName, 0, TPri_BelowNormal));
+		Workers.Add(MoveTemp(Worker));
+	}
+}
+
+void FSeuratImageWriter::Stop(bool bDiscardPendingJobs)
+{
+	if (bDiscardPendingJobs)
+	{
+		FScopeLock Lock(&QueueLock);
+		for (const TUniquePtr<FSeuratImageWriteJob>& Job : Jobs)
+		{
+			PendingBytes.Subtract(Job->GetSizeBytes());
+			PendingJobs.Decrement();
+			BufferPool->Release(MoveTemp(Job->Pixels));
+		}
+		Jobs.Empty();
+	}
+
+	bStopping = true;
+	for (FRunnableThread* Thread : Threads)
+	{
+		Thread->WaitForCompletion();
+		delete Thread;
+	}
+	Threads.Empty();
+	Workers.Empty();
+	// Images whose remaining tiles were discarded are left incomplete.
+	TiledImages.Empty();
+
+	if (WorkAvailable != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WorkAvailable);
+		WorkAvailable = nullptr;
+	}
+}
+
+bool FSeuratImageWriter::CanAccept(int64 SizeBytes) const
+{
+	const int64 QueuedBytes = PendingBytes.GetValue();
+	return QueuedBytes == 0 || QueuedBytes + SizeBytes <= MemoryBudgetBytes;
+}
+
+void FSeuratImageWriter::Enqueue(FSeuratImageWriteJob&& Job)
+{
+	check(Threads.Num() > 0);
+	PendingBytes.Add(Job.GetSizeBytes());
+	PendingJobs.Increment();
+	{
+		FScopeLock Lock(&QueueLock);
+		Jobs.Add(MakeUnique<FSeuratImageWriteJob>(MoveTemp(Job)));
+	}
+	WorkAvailable->Trigger();
+}
+
+bool FSeuratImageWriter::DequeueResult(FSeuratImageWriteResult& OutResult)
+{
+	return Results.Dequeue(OutResult);
+}
+
+bool FSeuratImageWriter::IsIdle() const
+{
+	return PendingJobs.GetValue() == 0;
+}
+
+int32 FSeuratImageWriter::GetNumFailedWrites() const
+{
+	return NumFailedWrites.GetValue();
+}
+
+TUniquePtr<FSeuratImageWriteJob> FSeuratImageWriter::DequeueJob()
+{
+	FScopeLock Lock(&QueueLock);
+	if (Jobs.Num() == 0)
+	{
+		return nullptr;
+	}
+	TUniquePtr<FSeuratImageWriteJob> Job = MoveTemp(Jobs[0]);
+	Jobs.RemoveAt(0, 1, false);
+	return Job;
+}
+
+void FSeuratImageWriter::WriteJob(const FSeuratImageWriteJob& Job, FSeuratImageWriteResult& OutResult)
+{
+	TArray<uint8> Encoded;
+	TArray<uint8> EncodedDepth;
+	const bool bSeparateDepth = ExrSettings.DepthEncoding == ECaptureDepthEncoding::Lossless;
+	bool bEncoded = false;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SeuratEncodeImage);
+		const double EncodeStartTime = FPlatformTime::Seconds();
+		bEncoded = EncodeSeuratExr(Job.Pixels, Job.Size, ExrSettings, Encoded);
+		if (bEncoded && bSeparateDepth)
+		{
+			TArray<float> Depths;
+			Depths.SetNumUninitialized(Job.Pixels.Num());
+			for (int32 PixelIndex = 0; PixelIndex < Job.Pixels.Num(); ++PixelIndex)
+			{
+				Depths[PixelIndex] = Job.Pixels[PixelIndex].A.GetFloat();
+			}
+			EncodeSeuratDepth(Depths.GetData(), Job.Size.X, Job.Size.Y, EncodedDepth);
+		}
+		OutResult.EncodeSeconds = FPlatformTime::Seconds() - EncodeStartTime;
+	}
+
+	if (bEncoded)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SeuratSaveImage);
+		const double WriteStartTime = FPlatformTime::Seconds();
+		// Depth is written first, so an image on disk always has its depth.
+		const bool bDepthWritten = !bSeparateDepth || SaveFile(EncodedDepth, FPaths::ChangeExtension(Job.Filename, SEURAT_DEPTH_EXTENSION));
+		OutResult.bSucceeded = bDepthWritten && SaveFile(Encoded, Job.Filename);
+		OutResult.WriteSeconds = FPlatformTime::Seconds() - WriteStartTime;
+	}
+
+	if (OutResult.bSucceeded)
+	{
+		OutResult.FileSizeBytes = Encoded.Num();
+		OutResult.DepthFileSizeBytes = EncodedDepth.Num();
+	}
+	else
+	{
+		NumFailedWrites.Increment();
+		UE_LOG(Seurat, Error, TEXT("Failed to write capture image %s."), *Job.Filename);
+	}
+}
+
+bool FSeuratImageWriter::WriteTile(const FSeuratImageWriteJob& Job, FSeuratImageWriteResult& OutResult)
+{
+	TSharedPtr<FTiledImage, ESPMode::ThreadSafe> Image;
+	{
+		FScopeLock Lock(&TiledImagesLock);
+		TSharedPtr<FTiledImage, ESPMode::ThreadSafe>& Found = TiledImages.FindOrAdd(Job.Filename);
+		if (!Found.IsValid())
+		{
+			Found = MakeShareable(new FTiledImage());
+			Found->Result = OutResult;
+			Found->NumTilesLeft = Job.NumTiles;
+		}
+		Image = Found;
+	}
+
+	FScopeLock Lock(&Image->Lock);
+	FSeuratImageWriteResult& Result = Image->Result;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SeuratEncodeImage);
+		const double EncodeStartTime = FPlatformTime::Seconds();
+		// The first tile to arrive creates the file. Each tile is compressed and
+		// written in one go, so its time counts as encoding.
+		if (!Image->bFailed && !Image->Exr.IsOpen())
+		{
+			Image->bFailed = !Image->Exr.Open(Job.Filename, Job.ImageSize, Job.Size, ExrSettings);
+		}
+		if (!Image->bFailed)
+		{
+			Image->bFailed = !Image->Exr.WriteTile(Job.Pixels, Job.TileOffset);
+		}
+		Result.EncodeSeconds += FPlatformTime::Seconds() - EncodeStartTime;
+	}
+	Result.MinDepth = FMath::Min(Result.MinDepth, OutResult.MinDepth);
+	Result.MaxDepth = FMath::Max(Result.MaxDepth, OutResult.MaxDepth);
+	if (--Image->NumTilesLeft > 0)
+	{
+		return false;
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SeuratSaveImage);
+		const double WriteStartTime = FPlatformTime::Seconds();
+		const bool bClosed = Image->Exr.Close();
+		Result.bSucceeded = bClosed && !Image->bFailed;
+		Result.WriteSeconds = FPlatformTime::Seconds() - WriteStartTime;
+	}
+	if (Result.bSucceeded)
+	{
+		Result.FileSizeBytes = IFileManager::Get().FileSize(*Job.Filename);
+	}
+	else
+	{
+		NumFailedWrites.Increment();
+		UE_LOG(Seurat, Error, TEXT("Failed to write capture image %s."), *Job.Filename);
+	}
+	OutResult = Result;
+	{
+		FScopeLock MapLock(&TiledImagesLock);
+		TiledImages.Remove(Job.Filename);
+	}
+	return true;
+}
+
+bool FSeuratImageWriter::SaveFile(const TArray<uint8>& Data, const FString& Filename)
+{
+	if (Pack != nullptr)
+	{
+		// Packed files are named relative to the output directory.
+		FSeuratPackEntry Entry;
+		return Pack->Append(FPaths::GetCleanFilename(Filename), Data.GetData(), Data.Num(), Entry);
+	}
+	return FFileHelper::SaveArrayToFile(Data, *Filename);
+}
+
+uint32 FSeuratImageWriter::FWorker::Run()
+{
+	while (true)
+	{
+		TUniquePtr<FSeuratImageWriteJob> Job = Owner.DequeueJob();
+		if (!Job.IsValid())
+		{
+			if (Owner.bStopping)
+			{
+				break;
+			}
+			Owner.WorkAvailable->Wait(kWorkerWaitMilliseconds);
+			continue;
+		}
+
+		FSeuratImageWriteResult Result;
+		Result.Filename = Job->Filename;
+		Result.Tag = Job->Tag;
+		Result.MinDepth = MAX_flt;
+		Result.MaxDepth = 0.0f;
+		for (const FFloat16Color& Pixel : Job->Pixels)
+		{
+			const float Depth = Pixel.A.GetFloat();
+			Result.MinDepth = FMath::Min(Result.MinDepth, Depth);
+			Result.MaxDepth = FMath::Max(Result.MaxDepth, Depth);
+		}
+		bool bHasResult = true;
+		if (Job->NumTiles > 1)
+		{
+			bHasResult = Owner.WriteTile(*Job, Result);
+		}
+		else
+		{
+			Owner.WriteJob(*Job, Result);
+		}
+
+		const int64 SizeBytes = Job->GetSizeBytes();
+		Owner.BufferPool->Release(MoveTemp(Job->Pixels));
+		Job.Reset();
+		// Publish the result before the job stops counting as pending, so it can
+		// be dequeued as soon as the writer reports being idle.
+		if (bHasResult)
+		{
+			Owner.Results.Enqueue(MoveTemp(Result));
+		}
+		Owner.PendingBytes.Subtract(SizeBytes);
+		Owner.PendingJobs.Decrement();
+	}
+	return 0;
+}
@@ -0,0 +1,149 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "Containers/Queue.h"
+#include "SeuratExrWriter.h"
+
+class FEvent;
+class FSeuratPackWriter;
+class FSeuratPixelBufferPool;
+class FRunnableThread;
+
+// A captured view waiting to be encoded and written to disk.
+struct FSeuratImageWriteJob
+{
+	FString Filename;
+	// Caller-defined value reported back with the result of the write.
+	int32 Tag;
+	FIntPoint Size;
+	TArray<FFloat16Color> Pixels;
+	// Views rendered in tiles are written one tile per job, and their result
+	// is reported once every tile is written. Size is then the size of a tile.
+	int32 NumTiles;
+	FIntPoint ImageSize;
+	FIntPoint TileOffset;
+
+	FSeuratImageWriteJob() : Tag(INDEX_NONE), Size(0, 0), NumTiles(1), ImageSize(0, 0), TileOffset(0, 0) {}
+
+	int64 GetSizeBytes() const { return Pixels.GetAllocatedSize(); }
+};
+
+// Outcome of a finished image write.
+struct FSeuratImageWriteResult
+{
+	FString Filename;
+	int32 Tag;
+	bool bSucceeded;
+	int64 FileSizeBytes;
+	// Size of the separate depth file, if depth is not in the image.
+	int64 DepthFileSizeBytes;
+	// Range of the depth stored in the alpha channel.
+	float MinDepth;
+	float MaxDepth;
+	double EncodeSeconds;
+	double WriteSeconds;
+
+	FSeuratImageWriteResult() : Tag(INDEX_NONE), bSucceeded(false), FileSizeBytes(0), DepthFileSizeBytes(0), MinDepth(0.0f), MaxDepth(0.0f), EncodeSeconds(0.0), WriteSeconds(0.0) {}
+};
+
+// Encodes captured views to EXR and writes them to disk on a pool of worker
+// threads, so compression and file I/O don't serialize with capture. The queue
+// is bounded by a memory budget; callers check CanAccept before enqueueing and
+// hold on to their data (stalling capture) while the writers catch up.
+class FSeuratImageWriter
+{
+public:
+	FSeuratImageWriter();
+	~FSeuratImageWriter();
+
+	// Pixel buffers of written and discarded jobs are returned to BufferPool.
+	// Images are appended to InPack, if given, rather than written as files.
+	void Start(int32 InNumThreads, int64 InMemoryBudgetBytes, const FSeuratExrSettings& InExrSettings, FSeuratPixelBufferPool& InBufferPool, FSeuratPackWriter* InPack = nullptr);
+	// Stops the worker threads. Pending jobs are written first unless discarded.
+	void Stop(bool bDiscardPendingJobs);
+
+	// Whether a job of the given size fits in the memory budget. A job is always
+	// accepted when nothing is queued, so oversized views still make progress.
+	bool CanAccept(int64 SizeBytes) const;
+	void Enqueue(FSeuratImageWriteJob&& Job);
+
+	// Returns the result of the next finished job, in completion order. Results
+	// of all written jobs are available once IsIdle returns true.
+	bool DequeueResult(FSeuratImageWriteResult& OutResult);
+
+	// True when every enqueued job has been written.
+	bool IsIdle() const;
+	int32 GetNumFailedWrites() const;
+
+private:
+	class FWorker : public FRunnable
+	{
+	public:
+		FWorker(FSeuratImageWriter& InOwner) : Owner(InOwner) {}
+
+		/** FRunnable implementation */
+		virtual uint32 Run() override;
+
+	private:
+		FSeuratImageWriter& Owner;
+	};
+
+	// An image that is being written one tile at a time.
+	struct FTiledImage
+	{
+		FSeuratTiledExrWriter Exr;
+		FSeuratImageWriteResult Result;
+		int32 NumTilesLeft;
+		bool bFailed;
+		// Serializes the writes of tiles of the image on different workers.
+		FCriticalSection Lock;
+
+		FTiledImage() : NumTilesLeft(0), bFailed(false) {}
+	};
+
+	TUniquePtr<FSeuratImageWriteJob> DequeueJob();
+	void WriteJob(const FSeuratImageWriteJob& Job, FSeuratImageWriteResult& OutResult);
+	// Returns true with the result of the image once its last tile is written.
+	bool WriteTile(const FSeuratImageWriteJob& Job, FSeuratImageWriteResult& OutResult);
+	bool SaveFile(const TArray<uint8>& Data, const FString& Filename);
+
+	FCriticalSection QueueLock;
+	TArray<TUniquePtr<FSeuratImageWriteJob>> Jobs;
+	FEvent* WorkAvailable;
+	TQueue<FSeuratImageWriteResult, EQueueMode::Mpsc> Results;
+	// Tiled images with tiles still to come, by file name.
+	FCriticalSection TiledImagesLock;
+	TMap<FString, TSharedPtr<FTiledImage, ESPMode::ThreadSafe>> TiledImages;
+
+	TArray<TUniquePtr<FWorker>> Workers;
+	TArray<FRunnableThread*> Threads;
+	FThreadSafeBool bStopping;
+
+	int64 MemoryBudgetBytes;
+	FSeuratExrSettings ExrSettings;
+	FSeuratPixelBufferPool* BufferPool;
+	FSeuratPackWriter* Pack;
+	// Bytes and jobs that are queued or being written.
+	FThreadSafeCounter64 PendingBytes;
+	FThreadSafeCounter PendingJobs;
+	FThreadSafeCounter NumFailedWrites;
+};
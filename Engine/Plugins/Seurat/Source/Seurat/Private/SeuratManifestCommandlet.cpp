@@ -0,0 +1,95 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratManifestCommandlet.h"
+#include "Seurat.h"
+#include "SeuratBinaryManifest.h"
+#include "SeuratPack.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+USeuratManifestCommandlet::USeuratManifestCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+// Writes the files of a pack to |OutputDirectory|, for tools that need loose
+// images.
+static bool UnpackImages(const FString& PackFilename, const FString& OutputDirectory)
+{
+	FSeuratPackReader Pack;
+	if (!Pack.Open(PackFilename))
+	{
+		return false;
+	}
+	TArray<uint8> Data;
+	for (const TPair<FString, FSeuratPackEntry>& Entry : Pack.GetEntries())
+	{
+		if (!Pack.Read(Entry.Value, Data) || !FFileHelper::SaveArrayToFile(Data, *(OutputDirectory / Entry.Key)))
+		{
+			UE_LOG(Seurat, Error, TEXT("Cannot unpack %s."), *Entry.Key);
+			return false;
+		}
+	}
+	UE_LOG(Seurat, Display, TEXT("Unpacked %d files to %s."), Pack.GetEntries().Num(), *OutputDirectory);
+	return true;
+}
+
+int32 USeuratManifestCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	const FString PackFilename = ParamVals.FindRef(TEXT("Unpack"));
+	if (!PackFilename.IsEmpty())
+	{
+		const FString OutputDirectory = ParamVals.Contains(TEXT("OutputDir")) ? ParamVals.FindRef(TEXT("OutputDir")) : FPaths::GetPath(PackFilename);
+		return UnpackImages(PackFilename, OutputDirectory) ? 0 : 1;
+	}
+
+	const FString InputFilename = ParamVals.FindRef(TEXT("Input"));
+	const FString OutputFilename = ParamVals.FindRef(TEXT("Output"));
+	TArray<FString> ShardFilenames;
+	ParamVals.FindRef(TEXT("Merge")).ParseIntoArray(ShardFilenames, TEXT(","), true);
+	if ((InputFilename.IsEmpty() && ShardFilenames.Num() == 0) || OutputFilename.IsEmpty())
+	{
+		UE_LOG(Seurat, Error, TEXT("Usage: -run=SeuratManifest -Input=<manifest> | -Merge=<manifests> -Output=<manifest> [-Compact] | -Unpack=<pack> [-OutputDir=<path>]"));
+		return 1;
+	}
+	if (ShardFilenames.Num() > 0)
+	{
+		TArray<FSeuratManifestViewGroup> ViewGroups;
+		if (!MergeSeuratManifestShards(ShardFilenames, ViewGroups) || !WriteSeuratManifest(OutputFilename, ViewGroups, FString(), Switches.Contains(TEXT("Compact"))))
+		{
+			UE_LOG(Seurat, Error, TEXT("Cannot merge %d manifests into %s."), ShardFilenames.Num(), *OutputFilename);
+			return 1;
+		}
+		UE_LOG(Seurat, Display, TEXT("Merged %d manifests into %s."), ShardFilenames.Num(), *OutputFilename);
+		return 0;
+	}
+	if (!ConvertSeuratManifest(InputFilename, OutputFilename, Switches.Contains(TEXT("Compact"))))
+	{
+		UE_LOG(Seurat, Error, TEXT("Cannot convert manifest %s to %s."), *InputFilename, *OutputFilename);
+		return 1;
+	}
+	UE_LOG(Seurat, Display, TEXT("Converted manifest %s to %s."), *InputFilename, *OutputFilename);
+	return 0;
+}
@@ -0,0 +1,43 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SeuratManifestCommandlet.generated.h"
+
+// Converts a capture manifest between manifest.json and the binary manifest
+// format. The format of each file follows from its extension: .smnf is binary,
+// anything else JSON. Also unpacks the images of a packed capture into loose
+// files, next to the pack unless OutputDir is given, and merges the manifests
+// of the shards of a capture into the manifest of the whole capture.
+//
+// Usage:
+//   UE4Editor-Cmd <Project> -run=SeuratManifest -Input=manifest.json
+//     -Output=manifest.smnf [-Compact]
+//   UE4Editor-Cmd <Project> -run=SeuratManifest -Unpack=capture.spak
+//     [-OutputDir=Path]
+//   UE4Editor-Cmd <Project> -run=SeuratManifest
+//     -Merge=Shard0/manifest.json,Shard1/manifest.json -Output=manifest.json
+//     [-Compact]
+UCLASS()
+class USeuratManifestCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	/** UCommandlet implementation */
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,197 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratReadback.h"
+#include "SeuratPixelBufferPool.h"
+#include "SeuratStats.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/TextureRenderTargetCube.h"
+#include "RenderingThread.h"
+#include "TextureResource.h"
+
+DECLARE_CYCLE_STAT(TEXT("Readback"), STAT_SeuratReadback, STATGROUP_Seurat);
+
+FSeuratReadbackRing::FSeuratReadbackRing() : BufferPool(nullptr), bCubeTargets(false), NextSlot(0), OldestSlot(0), AcquiredSlot(INDEX_NONE)
+{
+}
+
+void FSeuratReadbackRing::Initialize(int32 InNumSlots, int32 InResolution, bool bCube, FSeuratPixelBufferPool& InBufferPool)
+{
+	Release();
+
+	BufferPool = &InBufferPool;
+	bCubeTargets = bCube;
+	for (int32 SlotIndex = 0; SlotIndex < FMath::Max(InNumSlots, 1); ++SlotIndex)
+	{
+		TUniquePtr<FSeuratReadbackSlot> Slot = MakeUnique<FSeuratReadbackSlot>();
+		if (bCube)
+		{
+			UTextureRenderTargetCube* CubeTarget = NewObject<UTextureRenderTargetCube>();
+			CubeTarget->InitCustomFormat(InResolution, PF_FloatRGBA, true);
+			Slot->RenderTarget = CubeTarget;
+		}
+		else
+		{
+			UTextureRenderTarget2D* Target = NewObject<UTextureRenderTarget2D>();
+			Target->InitCustomFormat(InResolution, InResolution, PF_FloatRGBA, true);
+			Slot->RenderTarget = Target;
+		}
+		Slot->Size = FIntPoint(InResolution, InResolution);
+		Slots.Add(MoveTemp(Slot));
+	}
+}
+
+void FSeuratReadbackRing::Release()
+{
+	// The render thread may still be writing into the pixel arrays.
+	for (TUniquePtr<FSeuratReadbackSlot>& Slot : Slots)
+	{
+		Slot->Fence.Wait();
+		for (FSeuratReadbackImage& Image : Slot->Images)
+		{
+			if (Image.Pixels.Max() > 0)
+			{
+				BufferPool->Release(MoveTemp(Image.Pixels));
+			}
+		}
+	}
+	Slots.Empty();
+	NextSlot = 0;
+	OldestSlot = 0;
+	AcquiredSlot = INDEX_NONE;
+}
+
+bool FSeuratReadbackRing::HasFreeSlot() const
+{
+	return Slots.Num() > 0 && !Slots[NextSlot]->bInUse;
+}
+
+bool FSeuratReadbackRing::IsIdle() const
+{
+	for (const TUniquePtr<FSeuratReadbackSlot>& Slot : Slots)
+	{
+		if (Slot->bInUse)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+UTextureRenderTarget* FSeuratReadbackRing::AcquireTarget(int32 Resolution)
+{
+	if (!HasFreeSlot())
+	{
+		return nullptr;
+	}
+	AcquiredSlot = NextSlot;
+	NextSlot = (NextSlot + 1) % Slots.Num();
+
+	FSeuratReadbackSlot& Slot = *Slots[AcquiredSlot];
+	Slot.bInUse = true;
+	if (Resolution > 0 && Slot.Size.X != Resolution)
+	{
+		// The slot's last readback has completed, so its resource is unused.
+		if (bCubeTargets)
+		{
+			CastChecked<UTextureRenderTargetCube>(Slot.RenderTarget)->InitCustomFormat(Resolution, PF_FloatRGBA, true);
+		}
+		else
+		{
+			CastChecked<UTextureRenderTarget2D>(Slot.RenderTarget)->ResizeTarget(Resolution, Resolution);
+		}
+		Slot.Size = FIntPoint(Resolution, Resolution);
+	}
+	return Slot.RenderTarget;
+}
+
+void FSeuratReadbackRing::Submit(const TArray<FString>& Filenames, int32 Tag, int32 TileIndex)
+{
+	check(AcquiredSlot != INDEX_NONE);
+	FSeuratReadbackSlot& Slot = *Slots[AcquiredSlot];
+	AcquiredSlot = INDEX_NONE;
+
+	check(Filenames.Num() == (bCubeTargets ? CubeFace_MAX : 1));
+	Slot.Images.SetNum(Filenames.Num());
+	for (int32 ImageIndex = 0; ImageIndex < Filenames.Num(); ++ImageIndex)
+	{
+		Slot.Images[ImageIndex].Filename = Filenames[ImageIndex];
+		Slot.Images[ImageIndex].Tag = Tag;
+		Slot.Images[ImageIndex].TileIndex = TileIndex;
+		Slot.Images[ImageIndex].Pixels = BufferPool->Acquire(Slot.Size.X * Slot.Size.Y);
+		Slot.Images[ImageIndex].SubmitTime = FPlatformTime::Seconds();
+		Slot.Images[ImageIndex].CompleteTime = 0.0;
+	}
+	Slot.NumReported = 0;
+
+	// Render commands execute in order, so this runs after the CaptureScene
+	// command that filled the target. The target is PF_FloatRGBA, so reading
+	// it as half floats keeps every bit and avoids any conversion: color in
+	// linear space, and depth in centimeters in alpha.
+	ENQUEUE_UNIQUE_RENDER_COMMAND_TWOPARAMETER(
+		SeuratReadbackCommand,
+		FTextureRenderTargetResource*, RTResource, Slot.RenderTarget->GameThread_GetRenderTargetResource(),
+		TArray<FSeuratReadbackImage>*, OutImages, &Slot.Images,
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SeuratReadback);
+		FIntRect SourceRect(0, 0, RTResource->GetSizeXY().X, RTResource->GetSizeXY().Y);
+		for (int32 Face = 0; Face < OutImages->Num(); ++Face)
+		{
+			RHICmdList.ReadSurfaceFloatData(RTResource->GetRenderTargetTexture(), SourceRect, (*OutImages)[Face].Pixels, static_cast<ECubeFace>(Face), 0, 0);
+		}
+	});
+	Slot.Fence.BeginFence();
+}
+
+void FSeuratReadbackRing::Tick(TFunctionRef<bool(FSeuratReadbackImage&, FIntPoint)> OnReadbackComplete)
+{
+	// Slots complete in submission order, so only the oldest one needs polling.
+	while (Slots.Num() > 0 && OldestSlot != AcquiredSlot)
+	{
+		FSeuratReadbackSlot& Slot = *Slots[OldestSlot];
+		if (!Slot.bInUse || !Slot.Fence.IsFenceComplete())
+		{
+			break;
+		}
+		if (Slot.NumReported == 0 && Slot.Images[0].CompleteTime == 0.0)
+		{
+			const double CompleteTime = FPlatformTime::Seconds();
+			for (FSeuratReadbackImage& Image : Slot.Images)
+			{
+				Image.CompleteTime = CompleteTime;
+			}
+		}
+		while (Slot.NumReported < Slot.Images.Num())
+		{
+			FSeuratReadbackImage& Image = Slot.Images[Slot.NumReported];
+			if (!OnReadbackComplete(Image, Slot.Size))
+			{
+				return;
+			}
+			Image.Pixels.Reset();
+			++Slot.NumReported;
+		}
+		Slot.bInUse = false;
+		OldestSlot = (OldestSlot + 1) % Slots.Num();
+	}
+}
+
+void FSeuratReadbackRing::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (TUniquePtr<FSeuratReadbackSlot>& Slot : Slots)
+	{
+		Collector.AddReferencedObject(Slot->RenderTarget);
+	}
+}
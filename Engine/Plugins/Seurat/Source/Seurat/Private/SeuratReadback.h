@@ -0,0 +1,104 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderCommandFence.h"
+#include "UObject/GCObject.h"
+
+class FSeuratPixelBufferPool;
+class UTextureRenderTarget;
+
+// One image read back from a capture render target, at the half float
+// precision of the target.
+struct FSeuratReadbackImage
+{
+	FString Filename;
+	// Caller-defined value passed through with the image, e.g. its view group.
+	int32 Tag;
+	// Tile of the view the image holds, for views rendered in tiles.
+	int32 TileIndex;
+	TArray<FFloat16Color> Pixels;
+	// When the readback was enqueued, and when the ring first saw it complete.
+	double SubmitTime;
+	double CompleteTime;
+
+	FSeuratReadbackImage() : Tag(INDEX_NONE), TileIndex(0), SubmitTime(0.0), CompleteTime(0.0) {}
+};
+
+// A render target that a capture renders into, together with the CPU copy of
+// its contents once the render thread has read it back. 2D targets produce one
+// image; cube targets produce one image per face.
+struct FSeuratReadbackSlot
+{
+	UTextureRenderTarget* RenderTarget;
+	FIntPoint Size;
+	TArray<FSeuratReadbackImage> Images;
+	// Images already handed to the Tick callback.
+	int32 NumReported;
+	FRenderCommandFence Fence;
+	bool bInUse;
+
+	FSeuratReadbackSlot() : RenderTarget(nullptr), Size(0, 0), NumReported(0), bInUse(false) {}
+};
+
+// Multi-buffered readback of capture render targets. Each slot owns its own
+// render target, so the capture camera renders view N+1 into a fresh target
+// while the render thread still copies view N back to the CPU. The game thread
+// never flushes rendering; it polls the slot fences once per tick instead.
+class FSeuratReadbackRing : public FGCObject
+{
+public:
+	FSeuratReadbackRing();
+
+	// Creates the slot render targets, as cube targets if bCube is set. Pixel
+	// buffers for the readbacks are taken from BufferPool; consumers of the
+	// reported images return them there.
+	void Initialize(int32 InNumSlots, int32 InResolution, bool bCube, FSeuratPixelBufferPool& InBufferPool);
+	void Release();
+
+	bool HasFreeSlot() const;
+	bool IsIdle() const;
+
+	// Returns the render target of the next free slot, or nullptr if all slots
+	// are still waiting for their readback to complete. The target is resized
+	// to |Resolution| if given and different; captures issue their views from
+	// the highest resolution down, so each slot is resized rarely.
+	UTextureRenderTarget* AcquireTarget(int32 Resolution = 0);
+	// Enqueues the readback of the most recently acquired target. The pixels are
+	// reported by Tick with the given file names, tag and tile once the copy has
+	// finished; cube targets take one file name per face, in ECubeFace order.
+	void Submit(const TArray<FString>& Filenames, int32 Tag, int32 TileIndex = 0);
+
+	// Reports completed readbacks in submission order and recycles their slots.
+	// The callback may take ownership of the image pixels; returning false keeps
+	// the image, and all later ones, in the ring until the next Tick.
+	void Tick(TFunctionRef<bool(FSeuratReadbackImage&, FIntPoint)> OnReadbackComplete);
+
+	/** FGCObject implementation */
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+private:
+	TArray<TUniquePtr<FSeuratReadbackSlot>> Slots;
+	FSeuratPixelBufferPool* BufferPool;
+	bool bCubeTargets;
+	// Index of the slot that will be acquired next.
+	int32 NextSlot;
+	// Index of the oldest slot whose readback has not been reported yet.
+	int32 OldestSlot;
+	// Slot returned by the last AcquireTarget call and not yet submitted.
+	int32 AcquiredSlot;
+};
@@ -16,17 +16,68 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Dom/JsonObject.h"
 #include "Engine/EngineBaseTypes.h"
 #include "Framework/Commands/UICommandList.h"
-#include "ModuleManager.h"
-#include "HighResScreenshot.h"
+#include "JsonManifest.h"
+#include "Modules/ModuleManager.h"
 #include "TextureResource.h"
 #include "SceneCaptureSeurat.h"
+#include "SeuratBinaryManifest.h"
+#include "SeuratCaptureScheduler.h"
+#include "SeuratCaptureReport.h"
+#include "SeuratCheckpoint.h"
+#include "SeuratFaceCulling.h"
+#include "SeuratPack.h"
+#include "SeuratPixelBufferPool.h"
+#include "SeuratViewBounds.h"
+#include "SeuratImageWriter.h"
+#include "SeuratReadback.h"
 
 class FToolBarBuilder;
 class FMenuBuilder;
 
+// Options for a capture started from code rather than the capture button.
+struct FSeuratCaptureOptions
+{
+	// Directory that receives the images and manifest. Defaults to
+	// Intermediate/SeuratCapture in the project directory when empty.
+	FString OutputDirectory;
+	// Suppresses message dialogs, e.g. when capturing from a commandlet.
+	bool bUnattended;
+	// Updates the previous capture in OutputDirectory: only views that may see
+	// one of ChangedBounds are rendered again. The previous capture must have
+	// used the same settings.
+	bool bOnlyChangedViews;
+	// World space bounds of the scene changes since the previous capture,
+	// including the previous bounds of moved or deleted actors.
+	TArray<FBox> ChangedBounds;
+	// Captures only views [FirstView, EndView) of the capture, so a capture can
+	// be split across processes. Views are numbered sample by sample, six per
+	// sample in the order of the cube faces. The manifest of a partial capture
+	// records its range, for MergeSeuratManifestShards. EndView is the end of
+	// the capture if INDEX_NONE.
+	int32 FirstView;
+	int32 EndView;
+
+	FSeuratCaptureOptions() : bUnattended(false), bOnlyChangedViews(false), FirstView(0), EndView(INDEX_NONE) {}
+};
+
+// Views of one headbox sample, held until their images are on disk.
+struct FSeuratPendingViewGroup
+{
+	// One view per side; a view is filled in when its side is captured.
+	TArray<SeuratView> Views;
+	int32 NumViews;
+	// Images submitted for the views that have not been written yet.
+	int32 NumPendingImages;
+	// Sides that are not captured. They count towards NumViews, but their
+	// views are left out of the manifest.
+	uint32 CulledSides;
+	TArray<SeuratCulledFace> CulledFaces;
+
+	FSeuratPendingViewGroup() : NumViews(0), NumPendingImages(0), CulledSides(0) {}
+};
+
 class FSeuratModule : public IModuleInterface
 {
 public:
@@ -36,19 +87,54 @@ public:
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 
-	void BeginCapture(ASceneCaptureSeurat* InCaptureCamera);
+	// Returns false if the capture could not be started.
+	bool BeginCapture(ASceneCaptureSeurat* InCaptureCamera, const FSeuratCaptureOptions& InOptions = FSeuratCaptureOptions());
 	void EndCapture();
 	void CancelCapture();
 	void Tick(ELevelTick TickType, float DeltaSeconds);
 
+	bool IsCapturing() const { return bCapturing; }
+	// Directory a capture is written to if its options give none.
+	static FString GetDefaultOutputDirectory();
+	// Number of views a capture with the camera's settings has, for splitting
+	// it with FSeuratCaptureOptions::FirstView and EndView.
+	int32 GetNumCaptureViews(const ASceneCaptureSeurat* InCaptureCamera) const;
+	// Whether the last capture wrote every image and the manifest.
+	bool DidLastCaptureSucceed() const { return bLastCaptureSucceeded; }
+
 	// Fields related to capture process.
 	TArray<FVector> Samples;
-	TArray<TSharedPtr<FJsonValue>> ViewGroups;
-	TSharedPtr<FJsonObject> ViewGroup;
-	TArray<TSharedPtr<FJsonValue>> Views;
-	int32 CurrentSide;
-	int32 CurrentSample;
-	int32 CaptureTimer;
+	// Sample density at each headbox corner, for adaptive sampling.
+	TArray<float> CornerWeights;
+	// Capture resolution of each sample.
+	TArray<int32> SampleResolutions;
+	// Whether each side of each sample is culled, if faces are culled.
+	TArray<ESeuratFaceCull> FaceCulls;
+	// View groups of issued samples, keyed by sample index. Each group is
+	// appended to the manifest, in sample order, once its images are written.
+	TMap<int32, FSeuratPendingViewGroup> PendingViewGroups;
+	// Sample index of the next view group to append to the manifest.
+	int32 NextViewGroup;
+	FSeuratManifestWriter Manifest;
+	// View groups of manifest.smnf, written when the capture ends, if the
+	// capture camera asks for a binary manifest.
+	FSeuratBinaryManifestBuilder BinaryManifest;
+	bool bBinaryManifest;
+	// Receives the images if the capture camera packs them. Its complete
+	// records take the place of the checkpoint.
+	FSeuratPackWriter Pack;
+	// Records written images, so an interrupted capture can be resumed.
+	FSeuratCaptureCheckpoint Checkpoint;
+	// Depth ranges of the captured views, used to find the views a scene change
+	// affects.
+	FSeuratViewBoundsFile ViewBounds;
+	// Per-view timings, written to capture_report.json.
+	FSeuratCaptureReport Report;
+	// Issues one capture job per view; the capture ends when every job has
+	// retired and all pending readbacks and image writes have finished.
+	FSeuratCaptureScheduler Scheduler;
+	bool bCapturing;
+	bool bLastCaptureSucceeded;
 
 private:
 	void AddToolbarExtension(FToolBarBuilder& Builder);
@@ -56,11 +142,29 @@ private:
 
 	bool PauseTimeFlow(ASceneCaptureSeurat* InCaptureCamera);
 	void RestoreTimeFlow(ASceneCaptureSeurat* InCaptureCamera);
+	// Restores the capture camera, time flow and editor settings changed by
+	// BeginCapture, whether the capture ended, was cancelled or failed to start.
+	void RestoreEditorState();
 
 private:
 	TSharedPtr<class FUICommandList> PluginCommands;
 	TWeakObjectPtr<ASceneCaptureSeurat> ColorCameraActor;
+	FSeuratCaptureOptions Options;
+	// False when running with the null RHI. The capture then only plans the
+	// views and writes the manifest, so orchestration can run without a GPU.
+	bool bCanRender;
+	// Views above this resolution are rendered in tiles of at most this size.
+	int32 MaxTileResolution;
+	// Where the images store depth. Tiled images always keep it in the EXR.
+	ECaptureDepthEncoding DepthEncoding;
 	USceneCaptureComponent2D* ColorCamera;
+	// Components that render views in parallel. The first entry of ColorCameras
+	// is ColorCamera itself; the others are transient copies of its settings.
+	// In single pass cube mode, CubeCameras is used instead.
+	TArray<USceneCaptureComponent2D*> ColorCameras;
+	TArray<class USceneCaptureComponentCube*> CubeCameras;
+	// Pool component used by the next job issued this tick.
+	int32 NextPoolComponent;
 
 	// Saves and restores camera actor transformation.
 	FVector InitialPosition;
@@ -75,16 +179,54 @@ private:
 	// features enabled at the start of capture.
 	bool bNeedRestoreMonitorEditorPerformance;
 
+	// Pixel buffers of read back views, kept across captures. Declared before
+	// the readback ring and the image writer, which return buffers to it when
+	// they are destroyed.
+	FSeuratPixelBufferPool PixelBufferPool;
+	// Render targets the capture camera renders into, read back asynchronously.
+	FSeuratReadbackRing Readback;
+	// Encodes and writes read back views on worker threads.
+	FSeuratImageWriter ImageWriter;
+
 	// Transforms capture camera in world space to origin.
 	FMatrix WorldFromReferenceCameraMatrixSeurat;
 	// Stores the prefix of all capture output files.
 	FString BaseImageName;
 
-	void WriteImage(UTextureRenderTarget2D* InRenderTarget, FString Filename, bool bClearAlpha);
+	bool WriteImage(FSeuratReadbackImage& Image, FIntPoint Size);
+	void AppendCompletedViewGroups();
 	bool SaveStringTextToFile(FString SaveDirectory, FString FileName, FString SaveText, bool AllowOverWriting);
-	void CaptureSeurat();
-	TSharedPtr<FJsonObject> Capture(FRotator Orientation, FVector Position);
-	void GenerateJson(TSharedPtr<FJsonObject> JsonObject, FString ExportPath);
+	void ShowMessage(const FText& Message);
+	TSharedRef<ISeuratCaptureFence> CaptureSeurat(const FSeuratCaptureJob& Job);
+	TSharedRef<ISeuratCaptureFence> CaptureSeuratCube(const FSeuratCaptureJob& Job);
+	FMatrix GetViewWorldFromEye(int32 SampleIndex, int32 Side) const;
+	// Whether the images of a job from a previous capture are still valid,
+	// because a checkpoint recorded them or the scene change cannot affect them.
+	bool CanReuseImages(const FSeuratCaptureJob& Job) const;
+	bool ViewMayShowChange(const FMatrix& WorldFromEye, const FString& Filename) const;
+	// Whether an image of an interrupted capture is completely written.
+	bool IsImageComplete(const FString& Filename) const;
+	// Adds the views of a job to the manifest without rendering them.
+	void AddViewsWithoutCapture(const FSeuratCaptureJob& Job);
+	FSeuratPendingViewGroup& FindOrAddViewGroup(int32 SampleIndex);
+	// Whether a view is in the range of views of the capture.
+	bool IsViewInRange(int32 SampleIndex, int32 Side) const;
+	int32 GetNumViewsInRange(int32 SampleIndex) const;
+	SeuratView Capture(USceneCaptureComponent2D* Camera, FRotator Orientation, FVector Position, int32 Resolution);
+	SeuratView MakeView(const FMatrix& WorldFromEyeSampleCameraUnreal, int32 Resolution);
+	// Whether cube captures write depth to alpha, as the engine version may
+	// ignore their capture source. Renders one low resolution depth cube.
+	bool CanCaptureCubeDepth(ASceneCaptureSeurat* InCaptureCamera);
+	// Renders low resolution depth cubes at the headbox corners and derives
+	// the adaptive sample density at each corner from their disocclusion.
+	bool MeasureCornerWeights(ASceneCaptureSeurat* InCaptureCamera, TArray<float>& OutCornerWeights);
+	// Renders a low resolution depth cube at every sample and decides which
+	// sides not to capture.
+	bool CullFaces(int32 Resolution);
+	ESeuratFaceCull GetFaceCull(int32 SampleIndex, int32 Side) const;
+	void AddCulledView(FSeuratPendingViewGroup& ViewGroup, int32 SampleIndex, int32 Side);
+	void CreateCapturePool(int32 PoolSize, bool bCubeCapture);
+	void ReleaseCapturePool();
 };
 
 DECLARE_LOG_CATEGORY_EXTERN(Seurat, Log, All);
\ No newline at end of file
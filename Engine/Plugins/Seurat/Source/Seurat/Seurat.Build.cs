@@ -39,6 +39,7 @@ public class Seurat : ModuleRules
 			new string[]
 			{
 				"Core",
+				"SeuratCore",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -53,6 +54,8 @@ public class Seurat : ModuleRules
 				"LevelEditor",
 				"CoreUObject",
 				"Engine",
+				"RenderCore",
+				"RHI",
 				"Slate",
 				"SlateCore",
 				"Json",
@@ -68,5 +71,10 @@ public class Seurat : ModuleRules
 				// ... add any modules that your module loads dynamically here ...
 			}
 			);
+
+		// Capture images are encoded with OpenEXR directly, which controls the
+		// precision of each channel and the compression.
+		AddEngineThirdPartyPrivateStaticDependencies(Target, "UEOpenEXR");
+		bEnableExceptions = true;
 	}
 }
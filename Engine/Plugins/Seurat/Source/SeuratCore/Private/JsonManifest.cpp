@@ -0,0 +1,388 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "JsonManifest.h"
+#include "SeuratCore.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+FSeuratManifestWriter::FSeuratManifestWriter() : bCompact(false), NumViewGroups(0), TrailerOffset(0)
+{
+}
+
+FSeuratManifestWriter::~FSeuratManifestWriter()
+{
+	Close();
+}
+
+bool FSeuratManifestWriter::Open(const FString& Filename, bool bInCompact, const FString& PackPath, const FSeuratManifestShard* Shard)
+{
+	Close();
+
+	Archive.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Archive.IsValid())
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot create manifest %s."), *Filename);
+		return false;
+	}
+	bCompact = bInCompact;
+	NumViewGroups = 0;
+
+	// Line breaks match those of the pretty printed view groups.
+	FString Header = bCompact ? TEXT("{") : TEXT("{") LINE_TERMINATOR TEXT("\t");
+	if (!PackPath.IsEmpty())
+	{
+		Header += FString::Printf(bCompact ? TEXT("\"pack\":\"%s\",") : TEXT("\"pack\": \"%s\",") LINE_TERMINATOR TEXT("\t"), *PackPath.ReplaceCharWithEscapedChar());
+	}
+	if (Shard != nullptr)
+	{
+		Header += FString::Printf(bCompact
+			? TEXT("\"shard\":{\"first_view\":%d,\"end_view\":%d,\"num_views\":%d,\"views_per_group\":%d,\"settings_hash\":%u},")
+			: TEXT("\"shard\": {") LINE_TERMINATOR TEXT("\t\t\"first_view\": %d,") LINE_TERMINATOR TEXT("\t\t\"end_view\": %d,") LINE_TERMINATOR
+				TEXT("\t\t\"num_views\": %d,") LINE_TERMINATOR TEXT("\t\t\"views_per_group\": %d,") LINE_TERMINATOR TEXT("\t\t\"settings_hash\": %u") LINE_TERMINATOR TEXT("\t},") LINE_TERMINATOR TEXT("\t"),
+			Shard->FirstView, Shard->EndView, Shard->NumViews, Shard->ViewsPerGroup, Shard->SettingsHash);
+	}
+	Header += bCompact ? TEXT("\"view_groups\":[") : TEXT("\"view_groups\": [");
+	if (!WriteText(Header))
+	{
+		Close();
+		return false;
+	}
+	TrailerOffset = Archive->Tell();
+	return WriteTrailer();
+}
+
+bool FSeuratManifestWriter::AppendViewGroup(const TArray<SeuratView>& Views, const TArray<SeuratCulledFace>& CulledFaces)
+{
+	if (!Archive.IsValid())
+	{
+		return false;
+	}
+
+	FString Text;
+	if (NumViewGroups > 0)
+	{
+		Text += TEXT(",");
+	}
+	if (!bCompact)
+	{
+		Text += LINE_TERMINATOR TEXT("\t\t");
+	}
+	Text += ViewGroupToString(Views, bCompact, CulledFaces);
+
+	Archive->Seek(TrailerOffset);
+	if (!WriteText(Text))
+	{
+		return false;
+	}
+	TrailerOffset = Archive->Tell();
+	++NumViewGroups;
+	return WriteTrailer();
+}
+
+void FSeuratManifestWriter::Close()
+{
+	if (Archive.IsValid())
+	{
+		Archive->Close();
+		Archive.Reset();
+	}
+}
+
+template <class PrintPolicy>
+static void WriteViewGroupJson(TJsonWriter<TCHAR, PrintPolicy>& Writer, const TArray<SeuratView>& Views, const TArray<SeuratCulledFace>& CulledFaces)
+{
+	Writer.WriteObjectStart();
+	Writer.WriteArrayStart(TEXT("views"));
+	for (const SeuratView& View : Views)
+	{
+		View.WriteJson(Writer);
+	}
+	Writer.WriteArrayEnd();
+	if (CulledFaces.Num() > 0)
+	{
+		Writer.WriteArrayStart(TEXT("culled_faces"));
+		for (const SeuratCulledFace& CulledFace : CulledFaces)
+		{
+			CulledFace.WriteJson(Writer);
+		}
+		Writer.WriteArrayEnd();
+	}
+	Writer.WriteObjectEnd();
+}
+
+FString FSeuratManifestWriter::ViewGroupToString(const TArray<SeuratView>& Views, bool bCompact, const TArray<SeuratCulledFace>& CulledFaces)
+{
+	FString Text;
+	if (bCompact)
+	{
+		TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Text);
+		WriteViewGroupJson(*Writer, Views, CulledFaces);
+		Writer->Close();
+	}
+	else
+	{
+		// Indent the group as if it were written inside the view_groups array.
+		TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Text, 2);
+		WriteViewGroupJson(*Writer, Views, CulledFaces);
+		Writer->Close();
+	}
+	return Text;
+}
+
+bool FSeuratManifestWriter::WriteText(const FString& Text)
+{
+	FTCHARToUTF8 Utf8Text(*Text);
+	Archive->Serialize(const_cast<ANSICHAR*>(Utf8Text.Get()), Utf8Text.Length());
+	return !Archive->IsError();
+}
+
+bool FSeuratManifestWriter::WriteTrailer()
+{
+	// Leave the file position at the trailer, so the next group overwrites it.
+	if (!WriteText(bCompact ? TEXT("]}") : LINE_TERMINATOR TEXT("\t]") LINE_TERMINATOR TEXT("}")))
+	{
+		return false;
+	}
+	Archive->Flush();
+	Archive->Seek(TrailerOffset);
+	return !Archive->IsError();
+}
+
+// Inverse of WriteMatrixJson.
+static FMatrix ReadMatrixJson(const FJsonObject& Object, const FString& Identifier)
+{
+	FMatrix Matrix = FMatrix::Identity;
+	const TArray<TSharedPtr<FJsonValue>>* Elements = nullptr;
+	if (Object.TryGetArrayField(Identifier, Elements) && Elements->Num() == 16)
+	{
+		for (int32 i = 0; i < 4; i++)
+			for (int32 j = 0; j < 4; j++)
+			{
+				Matrix.M[j][i] = static_cast<float>((*Elements)[i * 4 + j]->AsNumber());
+			}
+	}
+	return Matrix;
+}
+
+static void ReadPackLocationJson(const FJsonObject& Object, PackLocation& OutPack)
+{
+	double Offset = 0.0;
+	double Size = 0.0;
+	if (Object.TryGetNumberField(TEXT("pack_offset"), Offset) && Object.TryGetNumberField(TEXT("pack_size"), Size))
+	{
+		OutPack.Offset = static_cast<int64>(Offset);
+		OutPack.Size = static_cast<int64>(Size);
+	}
+}
+
+static SeuratView ReadViewJson(const FJsonObject& Object)
+{
+	SeuratView View;
+	const TSharedPtr<FJsonObject>* Camera = nullptr;
+	if (Object.TryGetObjectField(TEXT("projective_camera"), Camera))
+	{
+		View.ProjectiveCamera.ImageWidth = (*Camera)->GetIntegerField(TEXT("image_width"));
+		View.ProjectiveCamera.ImageHeight = (*Camera)->GetIntegerField(TEXT("image_height"));
+		View.ProjectiveCamera.ClipFromEyeMatrix = ReadMatrixJson(**Camera, TEXT("clip_from_eye_matrix"));
+		View.ProjectiveCamera.WorldFromEyeMatrix = ReadMatrixJson(**Camera, TEXT("world_from_eye_matrix"));
+		View.ProjectiveCamera.DepthType = (*Camera)->GetStringField(TEXT("depth_type"));
+	}
+	const TSharedPtr<FJsonObject>* ImageFile = nullptr;
+	if (Object.TryGetObjectField(TEXT("depth_image_file"), ImageFile))
+	{
+		const TSharedPtr<FJsonObject>* Color = nullptr;
+		if ((*ImageFile)->TryGetObjectField(TEXT("color"), Color))
+		{
+			View.DepthImageFile.Color.Path = (*Color)->GetStringField(TEXT("path"));
+			View.DepthImageFile.Color.Channel0 = (*Color)->GetStringField(TEXT("channel_0"));
+			View.DepthImageFile.Color.Channel1 = (*Color)->GetStringField(TEXT("channel_1"));
+			View.DepthImageFile.Color.Channel2 = (*Color)->GetStringField(TEXT("channel_2"));
+			View.DepthImageFile.Color.ChannelAlpha = (*Color)->GetStringField(TEXT("channel_alpha"));
+			ReadPackLocationJson(**Color, View.DepthImageFile.Color.Pack);
+		}
+		const TSharedPtr<FJsonObject>* Depth = nullptr;
+		if ((*ImageFile)->TryGetObjectField(TEXT("depth"), Depth))
+		{
+			View.DepthImageFile.Depth.Path = (*Depth)->GetStringField(TEXT("path"));
+			View.DepthImageFile.Depth.Channel0 = (*Depth)->GetStringField(TEXT("channel_0"));
+			ReadPackLocationJson(**Depth, View.DepthImageFile.Depth.Pack);
+		}
+	}
+	return View;
+}
+
+bool ReadSeuratManifest(const FString& Filename, TArray<FSeuratManifestViewGroup>& OutViewGroups, FString* OutPackPath, FSeuratManifestShard* OutShard)
+{
+	OutViewGroups.Empty();
+
+	FString Text;
+	if (!FFileHelper::LoadFileToString(Text, *Filename))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot read manifest %s."), *Filename);
+		return false;
+	}
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(Text);
+	const TArray<TSharedPtr<FJsonValue>>* ViewGroups = nullptr;
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid() || !Root->TryGetArrayField(TEXT("view_groups"), ViewGroups))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot parse manifest %s."), *Filename);
+		return false;
+	}
+
+	if (OutPackPath != nullptr)
+	{
+		*OutPackPath = Root->HasField(TEXT("pack")) ? Root->GetStringField(TEXT("pack")) : FString();
+	}
+	if (OutShard != nullptr)
+	{
+		*OutShard = FSeuratManifestShard();
+		const TSharedPtr<FJsonObject>* Shard = nullptr;
+		if (Root->TryGetObjectField(TEXT("shard"), Shard))
+		{
+			OutShard->FirstView = (*Shard)->GetIntegerField(TEXT("first_view"));
+			OutShard->EndView = (*Shard)->GetIntegerField(TEXT("end_view"));
+			OutShard->NumViews = (*Shard)->GetIntegerField(TEXT("num_views"));
+			OutShard->ViewsPerGroup = (*Shard)->GetIntegerField(TEXT("views_per_group"));
+			OutShard->SettingsHash = static_cast<uint32>((*Shard)->GetNumberField(TEXT("settings_hash")));
+		}
+	}
+	OutViewGroups.Reserve(ViewGroups->Num());
+	for (const TSharedPtr<FJsonValue>& GroupValue : *ViewGroups)
+	{
+		FSeuratManifestViewGroup& ViewGroup = OutViewGroups[OutViewGroups.AddDefaulted()];
+		const TSharedPtr<FJsonObject> Group = GroupValue->AsObject();
+		if (!Group.IsValid())
+		{
+			continue;
+		}
+		const TArray<TSharedPtr<FJsonValue>>* Views = nullptr;
+		if (Group->TryGetArrayField(TEXT("views"), Views))
+		{
+			for (const TSharedPtr<FJsonValue>& ViewValue : *Views)
+			{
+				const TSharedPtr<FJsonObject> View = ViewValue->AsObject();
+				if (View.IsValid())
+				{
+					ViewGroup.Views.Add(ReadViewJson(*View));
+				}
+			}
+		}
+		const TArray<TSharedPtr<FJsonValue>>* CulledFaces = nullptr;
+		if (Group->TryGetArrayField(TEXT("culled_faces"), CulledFaces))
+		{
+			for (const TSharedPtr<FJsonValue>& CulledFaceValue : *CulledFaces)
+			{
+				const TSharedPtr<FJsonObject> CulledFace = CulledFaceValue->AsObject();
+				if (CulledFace.IsValid())
+				{
+					SeuratCulledFace& Face = ViewGroup.CulledFaces[ViewGroup.CulledFaces.AddDefaulted()];
+					Face.Face = CulledFace->GetStringField(TEXT("face"));
+					Face.Reason = CulledFace->GetStringField(TEXT("reason"));
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool MergeSeuratManifestShards(const TArray<FString>& ShardFilenames, TArray<FSeuratManifestViewGroup>& OutViewGroups)
+{
+	OutViewGroups.Empty();
+
+	struct FShardManifest
+	{
+		FString Filename;
+		FSeuratManifestShard Range;
+		TArray<FSeuratManifestViewGroup> ViewGroups;
+	};
+	TArray<FShardManifest> Shards;
+	for (const FString& Filename : ShardFilenames)
+	{
+		FShardManifest& Shard = Shards[Shards.AddDefaulted()];
+		Shard.Filename = Filename;
+		if (!ReadSeuratManifest(Filename, Shard.ViewGroups, nullptr, &Shard.Range))
+		{
+			return false;
+		}
+		if (!Shard.Range.IsValid())
+		{
+			UE_LOG(SeuratCore, Error, TEXT("%s is not the manifest of a capture shard."), *Filename);
+			return false;
+		}
+	}
+	if (Shards.Num() == 0)
+	{
+		UE_LOG(SeuratCore, Error, TEXT("No capture shards to merge."));
+		return false;
+	}
+
+	// The shards must be of one capture and cover each of its views once.
+	Shards.Sort([](const FShardManifest& A, const FShardManifest& B) { return A.Range.FirstView < B.Range.FirstView; });
+	const FSeuratManifestShard& Capture = Shards[0].Range;
+	int32 NextView = 0;
+	for (const FShardManifest& Shard : Shards)
+	{
+		if (Shard.Range.NumViews != Capture.NumViews || Shard.Range.ViewsPerGroup != Capture.ViewsPerGroup || Shard.Range.SettingsHash != Capture.SettingsHash)
+		{
+			UE_LOG(SeuratCore, Error, TEXT("%s is a shard of a different capture than %s."), *Shard.Filename, *Shards[0].Filename);
+			return false;
+		}
+		if (Shard.Range.FirstView != NextView || Shard.Range.EndView < Shard.Range.FirstView)
+		{
+			UE_LOG(SeuratCore, Error, TEXT("%s covers views %d to %d, but the next shard must start at view %d."), *Shard.Filename, Shard.Range.FirstView, Shard.Range.EndView, NextView);
+			return false;
+		}
+		NextView = Shard.Range.EndView;
+	}
+	if (NextView != Capture.NumViews)
+	{
+		UE_LOG(SeuratCore, Error, TEXT("The shards cover %d of %d views."), NextView, Capture.NumViews);
+		return false;
+	}
+
+	// A view group split between shards is split in side order, so appending
+	// the parts in shard order keeps its views and culled faces in side order.
+	const int32 ViewsPerGroup = Capture.ViewsPerGroup;
+	OutViewGroups.SetNum(FMath::DivideAndRoundUp(Capture.NumViews, ViewsPerGroup));
+	for (const FShardManifest& Shard : Shards)
+	{
+		const int32 FirstGroup = Shard.Range.FirstView / ViewsPerGroup;
+		const int32 NumGroups = Shard.Range.EndView > Shard.Range.FirstView ? FMath::DivideAndRoundUp(Shard.Range.EndView, ViewsPerGroup) - FirstGroup : 0;
+		if (Shard.ViewGroups.Num() != NumGroups)
+		{
+			UE_LOG(SeuratCore, Error, TEXT("%s has %d of its %d view groups; its capture is incomplete."), *Shard.Filename, Shard.ViewGroups.Num(), NumGroups);
+			return false;
+		}
+		for (int32 Index = 0; Index < NumGroups; ++Index)
+		{
+			const int32 GroupIndex = FirstGroup + Index;
+			const int32 NumGroupViews = FMath::Min(Shard.Range.EndView, (GroupIndex + 1) * ViewsPerGroup) - FMath::Max(Shard.Range.FirstView, GroupIndex * ViewsPerGroup);
+			const FSeuratManifestViewGroup& Part = Shard.ViewGroups[Index];
+			if (Part.Views.Num() + Part.CulledFaces.Num() != NumGroupViews)
+			{
+				UE_LOG(SeuratCore, Error, TEXT("View group %d of %s has %d of its %d views."), GroupIndex, *Shard.Filename, Part.Views.Num() + Part.CulledFaces.Num(), NumGroupViews);
+				return false;
+			}
+			OutViewGroups[GroupIndex].Views.Append(Part.Views);
+			OutViewGroups[GroupIndex].CulledFaces.Append(Part.CulledFaces);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,467 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratBenchmark.h"
+#include "SeuratCore.h"
+#include "SeuratBinaryManifest.h"
+#include "SeuratDepthCodec.h"
+#include "SeuratLowDiscrepancy.h"
+#include "JsonManifest.h"
+#include "SeuratMath.h"
+#include "SeuratSampling.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Math/Float16.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+
+// Results are folded into this, so the compiler cannot drop benchmark work.
+static volatile float GBenchmarkSink = 0.0f;
+
+FSeuratBenchmarkResult RunSeuratBenchmark(const FString& Name, int64 ItemsPerIteration, double MinSeconds, TFunctionRef<void()> Body)
+{
+	FSeuratBenchmarkResult Result;
+	Result.Name = Name;
+	Result.ItemsPerIteration = ItemsPerIteration;
+
+	// Warm up caches and allocators before timing.
+	Body();
+
+	const double StartTime = FPlatformTime::Seconds();
+	double ElapsedSeconds = 0.0;
+	do
+	{
+		Body();
+		++Result.Iterations;
+		ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+	} while (ElapsedSeconds < MinSeconds);
+
+	Result.SecondsPerIteration = ElapsedSeconds / Result.Iterations;
+	UE_LOG(SeuratCore, Display, TEXT("%-40s %10d iterations %14.1f ns/item %14.0f items/s"),
+		*Name, Result.Iterations, Result.GetNanosecondsPerItem(), Result.GetItemsPerSecond());
+	return Result;
+}
+
+static bool PassesFilter(const FSeuratBenchmarkOptions& Options, const FString& Name)
+{
+	return Options.Filter.IsEmpty() || Name.Contains(Options.Filter);
+}
+
+// A plausible view of a sample capture, for serialization benchmarks.
+static SeuratView MakeBenchmarkView(int32 ViewIndex, FRandomStream& Random)
+{
+	SeuratView View;
+	View.ProjectiveCamera.ImageWidth = 1024;
+	View.ProjectiveCamera.ImageHeight = 1024;
+	View.ProjectiveCamera.ClipFromEyeMatrix = SeuratClipFromEyeMatrix(10.0f);
+	View.ProjectiveCamera.WorldFromEyeMatrix = CubeFaceWorldFromEye(ViewIndex % 6, Random.GetUnitVector() * 50.0f);
+	View.ProjectiveCamera.DepthType = "EYE_Z";
+	const FString ImageName = FString::Printf(TEXT("Cube_Front_%d_ColorDepth.exr"), ViewIndex / 6);
+	View.DepthImageFile.Color.Path = ImageName;
+	View.DepthImageFile.Color.Channel0 = "R";
+	View.DepthImageFile.Color.Channel1 = "G";
+	View.DepthImageFile.Color.Channel2 = "B";
+	View.DepthImageFile.Color.ChannelAlpha = "CONSTANT_ONE";
+	View.DepthImageFile.Depth.Path = ImageName;
+	View.DepthImageFile.Depth.Channel0 = "A";
+	return View;
+}
+
+// Eye space depth of a scene of tilted planes and boxes, at the half precision
+// of read back depth. Like captured depth, it is smooth but for depth edges.
+static void MakeBenchmarkDepth(int32 Size, FRandomStream& Random, FSeuratBenchmarkDepthImage& OutImage)
+{
+	OutImage.Name = FString::Printf(TEXT("Synthetic%d"), Size);
+	OutImage.Width = Size;
+	OutImage.Height = Size;
+	OutImage.Depths.SetNumUninitialized(Size * Size);
+
+	const int32 kNumBoxes = 32;
+	TArray<FBox2D> Boxes;
+	TArray<float> BoxDepths;
+	for (int32 BoxIndex = 0; BoxIndex < kNumBoxes; ++BoxIndex)
+	{
+		const FVector2D Min(Random.FRand(), Random.FRand());
+		Boxes.Add(FBox2D(Min, Min + FVector2D(Random.FRandRange(0.02f, 0.3f), Random.FRandRange(0.02f, 0.3f))));
+		BoxDepths.Add(Random.FRandRange(100.0f, 2000.0f));
+	}
+	for (int32 Y = 0; Y < Size; ++Y)
+	{
+		for (int32 X = 0; X < Size; ++X)
+		{
+			const FVector2D Position(static_cast<float>(X) / Size, static_cast<float>(Y) / Size);
+			// Floor and far wall.
+			float Depth = Position.Y > 0.5f ? 150.0f / (Position.Y - 0.5f + 0.05f) : 3000.0f + 500.0f * Position.X;
+			for (int32 BoxIndex = 0; BoxIndex < kNumBoxes; ++BoxIndex)
+			{
+				if (Boxes[BoxIndex].IsInside(Position))
+				{
+					Depth = FMath::Min(Depth, BoxDepths[BoxIndex] + 200.0f * (Position.X - Boxes[BoxIndex].Min.X));
+				}
+			}
+			OutImage.Depths[Y * Size + X] = FFloat16(Depth).GetFloat();
+		}
+	}
+}
+
+// Returns false if the depth does not round trip through the codec.
+static bool RunDepthCodecBenchmarks(const FSeuratBenchmarkOptions& Options, const FSeuratBenchmarkDepthImage& Image, TArray<FSeuratBenchmarkResult>& OutResults)
+{
+	const FString EncodeName = FString::Printf(TEXT("DepthEncode/%s"), *Image.Name);
+	const FString DecodeName = FString::Printf(TEXT("DepthDecode/%s"), *Image.Name);
+	if (!PassesFilter(Options, EncodeName) && !PassesFilter(Options, DecodeName))
+	{
+		return true;
+	}
+
+	const int32 NumPixels = Image.Width * Image.Height;
+	TArray<uint8> Encoded;
+	EncodeSeuratDepth(Image.Depths.GetData(), Image.Width, Image.Height, Encoded);
+	UE_LOG(SeuratCore, Display, TEXT("Depth %s: %d bytes, %.2f bits/pixel, %.2fx smaller than float"),
+		*Image.Name, Encoded.Num(), Encoded.Num() * 8.0 / FMath::Max(NumPixels, 1), NumPixels * sizeof(float) / static_cast<double>(Encoded.Num()));
+
+	if (PassesFilter(Options, EncodeName))
+	{
+		TArray<uint8> Data;
+		OutResults.Add(RunSeuratBenchmark(EncodeName, NumPixels, Options.MinSeconds, [&Image, &Data]()
+		{
+			EncodeSeuratDepth(Image.Depths.GetData(), Image.Width, Image.Height, Data);
+			GBenchmarkSink = GBenchmarkSink + Data.Num();
+		}));
+	}
+
+	// Checked before timing, so a broken codec fails fast rather than being
+	// measured.
+	TArray<float> Depths;
+	int32 Width = 0;
+	int32 Height = 0;
+	if (!DecodeSeuratDepth(Encoded.GetData(), Encoded.Num(), Depths, Width, Height) ||
+		Width != Image.Width || Height != Image.Height || Depths.Num() != Image.Depths.Num() ||
+		FMemory::Memcmp(Depths.GetData(), Image.Depths.GetData(), Depths.Num() * sizeof(float)) != 0)
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Depth %s does not round trip through the depth codec."), *Image.Name);
+		return false;
+	}
+
+	if (PassesFilter(Options, DecodeName))
+	{
+		OutResults.Add(RunSeuratBenchmark(DecodeName, NumPixels, Options.MinSeconds, [&Encoded, &Depths, &Width, &Height]()
+		{
+			DecodeSeuratDepth(Encoded.GetData(), Encoded.Num(), Depths, Width, Height);
+			GBenchmarkSink = GBenchmarkSink + Depths.Num();
+		}));
+	}
+	return true;
+}
+
+bool RunSeuratCoreBenchmarks(const FSeuratBenchmarkOptions& Options, TArray<FSeuratBenchmarkResult>& OutResults)
+{
+	FRandomStream Random(0x5e0a7);
+	const FTransform HeadboxToWorld(FRotator(0.0f, 30.0f, 0.0f), FVector(100.0f, -200.0f, 50.0f));
+
+	for (int32 NumSamples : Options.SampleCounts)
+	{
+		const FString RadicalInverseName = FString::Printf(TEXT("RadicalInverse/%d"), NumSamples);
+		if (PassesFilter(Options, RadicalInverseName))
+		{
+			OutResults.Add(RunSeuratBenchmark(RadicalInverseName, NumSamples, Options.MinSeconds, [NumSamples]()
+			{
+				float Sum = 0.0f;
+				for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+				{
+					Sum += RadicalInverse(SampleIndex, 3);
+				}
+				GBenchmarkSink = GBenchmarkSink + Sum;
+			}));
+		}
+
+		for (bool bScramble : { false, true })
+		{
+			const FString SobolName = FString::Printf(TEXT("%sSobol3D/%d"), bScramble ? TEXT("Scrambled") : TEXT(""), NumSamples);
+			if (PassesFilter(Options, SobolName))
+			{
+				const FSeuratLowDiscrepancySequence Sequence(ESeuratSequence::Sobol, 3, bScramble, 1);
+				TArray<TArray<float>> Coordinates;
+				OutResults.Add(RunSeuratBenchmark(SobolName, NumSamples, Options.MinSeconds, [&]()
+				{
+					Sequence.Generate(0, NumSamples, Coordinates);
+					GBenchmarkSink = GBenchmarkSink + Coordinates[2].Last();
+				}));
+			}
+		}
+
+		const FString SamplesName = FString::Printf(TEXT("GenerateHeadboxSamples/%d"), NumSamples);
+		if (PassesFilter(Options, SamplesName))
+		{
+			TArray<FVector> Samples;
+			OutResults.Add(RunSeuratBenchmark(SamplesName, NumSamples, Options.MinSeconds, [&]()
+			{
+				GenerateHeadboxSamples(NumSamples, FVector(100.0f, 100.0f, 100.0f), HeadboxToWorld, Samples);
+				GBenchmarkSink = GBenchmarkSink + Samples.Last().X;
+			}));
+		}
+	}
+
+	const FString MatrixName = FString::Printf(TEXT("SeuratMatrixFromUnrealMatrix/%d"), Options.NumMatrices);
+	if (PassesFilter(Options, MatrixName))
+	{
+		TArray<FMatrix> Matrices;
+		Matrices.Reserve(Options.NumMatrices);
+		for (int32 MatrixIndex = 0; MatrixIndex < Options.NumMatrices; ++MatrixIndex)
+		{
+			Matrices.Add(FTransform(FRotator(Random.FRandRange(-90.0f, 90.0f), Random.FRandRange(0.0f, 360.0f), 0.0f), Random.GetUnitVector() * 100.0f).ToMatrixNoScale());
+		}
+		OutResults.Add(RunSeuratBenchmark(MatrixName, Options.NumMatrices, Options.MinSeconds, [&Matrices]()
+		{
+			float Sum = 0.0f;
+			for (const FMatrix& Matrix : Matrices)
+			{
+				Sum += SeuratMatrixFromUnrealMatrix(Matrix).M[3][0];
+			}
+			GBenchmarkSink = GBenchmarkSink + Sum;
+		}));
+	}
+
+	for (int32 NumViews : Options.ViewCounts)
+	{
+		const int32 NumViewGroups = FMath::Max(NumViews / 6, 1);
+		TArray<SeuratView> ViewGroup;
+		for (int32 ViewIndex = 0; ViewIndex < 6; ++ViewIndex)
+		{
+			ViewGroup.Add(MakeBenchmarkView(ViewIndex, Random));
+		}
+
+		for (bool bCompact : { false, true })
+		{
+			const FString SerializeName = FString::Printf(TEXT("ManifestSerialize%s/%d"), bCompact ? TEXT("Compact") : TEXT("Pretty"), NumViewGroups * 6);
+			if (PassesFilter(Options, SerializeName))
+			{
+				OutResults.Add(RunSeuratBenchmark(SerializeName, NumViewGroups * 6, Options.MinSeconds, [&ViewGroup, NumViewGroups, bCompact]()
+				{
+					int32 Length = 0;
+					for (int32 GroupIndex = 0; GroupIndex < NumViewGroups; ++GroupIndex)
+					{
+						Length += FSeuratManifestWriter::ViewGroupToString(ViewGroup, bCompact).Len();
+					}
+					GBenchmarkSink = GBenchmarkSink + Length;
+				}));
+			}
+		}
+
+		// Includes the file system, so results depend on the disk.
+		const FString WriteName = FString::Printf(TEXT("ManifestWrite/%d"), NumViewGroups * 6);
+		if (PassesFilter(Options, WriteName))
+		{
+			const FString Filename = FPaths::Combine(FPlatformProcess::UserTempDir(), TEXT("SeuratBenchmarkManifest.json"));
+			OutResults.Add(RunSeuratBenchmark(WriteName, NumViewGroups * 6, Options.MinSeconds, [&ViewGroup, NumViewGroups, &Filename]()
+			{
+				FSeuratManifestWriter Manifest;
+				Manifest.Open(Filename, true);
+				for (int32 GroupIndex = 0; GroupIndex < NumViewGroups; ++GroupIndex)
+				{
+					Manifest.AppendViewGroup(ViewGroup);
+				}
+				Manifest.Close();
+			}));
+			IFileManager::Get().Delete(*Filename);
+		}
+
+		const FString BinaryName = FString::Printf(TEXT("BinaryManifestSerialize/%d"), NumViewGroups * 6);
+		const FString LookupName = FString::Printf(TEXT("BinaryManifestLookup/%d"), NumViewGroups * 6);
+		if (PassesFilter(Options, BinaryName) || PassesFilter(Options, LookupName))
+		{
+			FSeuratBinaryManifestBuilder Builder;
+			for (int32 GroupIndex = 0; GroupIndex < NumViewGroups; ++GroupIndex)
+			{
+				Builder.AddViewGroup(ViewGroup);
+			}
+			TArray<uint8> Data;
+			if (PassesFilter(Options, BinaryName))
+			{
+				OutResults.Add(RunSeuratBenchmark(BinaryName, NumViewGroups * 6, Options.MinSeconds, [&Builder, &Data]()
+				{
+					Builder.Serialize(Data);
+					GBenchmarkSink = GBenchmarkSink + Data.Num();
+				}));
+			}
+			// Opens the manifest and reads every view's camera, as tools do after
+			// mapping the file.
+			Builder.Serialize(Data);
+			if (PassesFilter(Options, LookupName))
+			{
+				OutResults.Add(RunSeuratBenchmark(LookupName, NumViewGroups * 6, Options.MinSeconds, [&Data]()
+				{
+					FSeuratBinaryManifest Manifest;
+					Manifest.Initialize(Data.GetData(), Data.Num());
+					float Sum = 0.0f;
+					for (int32 ViewIndex = 0; ViewIndex < Manifest.GetNumViews(); ++ViewIndex)
+					{
+						Sum += Manifest.GetView(ViewIndex).WorldFromEyeMatrix[12];
+					}
+					GBenchmarkSink = GBenchmarkSink + Sum;
+				}));
+			}
+		}
+	}
+
+	bool bSucceeded = true;
+	for (int32 Size : Options.DepthSizes)
+	{
+		FSeuratBenchmarkDepthImage Image;
+		MakeBenchmarkDepth(Size, Random, Image);
+		bSucceeded &= RunDepthCodecBenchmarks(Options, Image, OutResults);
+	}
+	for (const FSeuratBenchmarkDepthImage& Image : Options.DepthImages)
+	{
+		bSucceeded &= RunDepthCodecBenchmarks(Options, Image, OutResults);
+	}
+	return bSucceeded;
+}
+
+static void ParseCounts(const TCHAR* CommandLine, const TCHAR* Name, TArray<int32>& OutCounts)
+{
+	FString Value;
+	if (!FParse::Value(CommandLine, Name, Value, false) || Value.IsEmpty())
+	{
+		return;
+	}
+	TArray<FString> Counts;
+	Value.ParseIntoArray(Counts, TEXT(","), true);
+	OutCounts.Empty(Counts.Num());
+	for (const FString& Count : Counts)
+	{
+		OutCounts.Add(FMath::Max(FCString::Atoi(*Count), 1));
+	}
+}
+
+void ParseSeuratBenchmarkOptions(const TCHAR* CommandLine, FSeuratBenchmarkOptions& OutOptions)
+{
+	ParseCounts(CommandLine, TEXT("Samples="), OutOptions.SampleCounts);
+	ParseCounts(CommandLine, TEXT("Views="), OutOptions.ViewCounts);
+	ParseCounts(CommandLine, TEXT("DepthSizes="), OutOptions.DepthSizes);
+	int32 NumMatrices = 0;
+	if (FParse::Value(CommandLine, TEXT("Matrices="), NumMatrices))
+	{
+		OutOptions.NumMatrices = FMath::Max(NumMatrices, 1);
+	}
+	double MinSeconds = 0.0;
+	if (FParse::Value(CommandLine, TEXT("MinTime="), MinSeconds))
+	{
+		OutOptions.MinSeconds = FMath::Max(MinSeconds, 0.0);
+	}
+	FParse::Value(CommandLine, TEXT("Filter="), OutOptions.Filter);
+	FParse::Value(CommandLine, TEXT("DepthImages="), OutOptions.DepthImageDirectory);
+	FParse::Value(CommandLine, TEXT("Output="), OutOptions.OutputFilename);
+}
+
+void LoadSeuratBenchmarkDepthImages(const FString& Directory, TArray<FSeuratBenchmarkDepthImage>& OutImages)
+{
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *(Directory / (FString(TEXT("*.")) + SEURAT_DEPTH_EXTENSION)), true, false);
+	Filenames.Sort();
+	for (const FString& Filename : Filenames)
+	{
+		TArray<uint8> Data;
+		FSeuratBenchmarkDepthImage Image;
+		if (!FFileHelper::LoadFileToArray(Data, *(Directory / Filename)) ||
+			!DecodeSeuratDepth(Data.GetData(), Data.Num(), Image.Depths, Image.Width, Image.Height))
+		{
+			UE_LOG(SeuratCore, Warning, TEXT("Cannot read depth image %s."), *(Directory / Filename));
+			continue;
+		}
+		Image.Name = FPaths::GetBaseFilename(Filename);
+		OutImages.Add(MoveTemp(Image));
+	}
+}
+
+bool SaveSeuratBenchmarkResults(const FString& Filename, const TArray<FSeuratBenchmarkResult>& Results)
+{
+	FString Json;
+	TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("platform"), FString(FPlatformProperties::IniPlatformName()));
+	Writer->WriteArrayStart(TEXT("benchmarks"));
+	for (const FSeuratBenchmarkResult& Result : Results)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("name"), Result.Name);
+		Writer->WriteValue(TEXT("iterations"), Result.Iterations);
+		Writer->WriteValue(TEXT("items_per_iteration"), static_cast<double>(Result.ItemsPerIteration));
+		Writer->WriteValue(TEXT("seconds_per_iteration"), Result.SecondsPerIteration);
+		Writer->WriteValue(TEXT("ns_per_item"), Result.GetNanosecondsPerItem());
+		Writer->WriteValue(TEXT("items_per_second"), Result.GetItemsPerSecond());
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+	return FFileHelper::SaveStringToFile(Json, *Filename);
+}
+
+int32 RunSeuratBenchmarkSuite(const FSeuratBenchmarkOptions& InOptions)
+{
+	FSeuratBenchmarkOptions Options = InOptions;
+	if (!Options.DepthImageDirectory.IsEmpty())
+	{
+		LoadSeuratBenchmarkDepthImages(Options.DepthImageDirectory, Options.DepthImages);
+		if (Options.DepthImages.Num() == 0)
+		{
+			UE_LOG(SeuratCore, Warning, TEXT("No depth images in %s."), *Options.DepthImageDirectory);
+		}
+	}
+
+	TArray<FSeuratBenchmarkResult> Results;
+	const bool bSucceeded = RunSeuratCoreBenchmarks(Options, Results);
+	if (!bSucceeded)
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Benchmarks computed wrong results."));
+	}
+	if (Results.Num() == 0)
+	{
+		UE_LOG(SeuratCore, Error, TEXT("No benchmarks match filter %s."), *Options.Filter);
+		return 1;
+	}
+
+	if (!Options.OutputFilename.IsEmpty())
+	{
+		if (!SaveSeuratBenchmarkResults(Options.OutputFilename, Results))
+		{
+			UE_LOG(SeuratCore, Error, TEXT("Cannot write benchmark results to %s."), *Options.OutputFilename);
+			return 1;
+		}
+		UE_LOG(SeuratCore, Display, TEXT("Wrote %d benchmark results to %s."), Results.Num(), *Options.OutputFilename);
+	}
+	return bSucceeded ? 0 : 1;
+}
+
+// Runs the benchmarks in any application with the core module, e.g. a game
+// started with -nullrhi -ExecCmds="Seurat.Benchmark -Filter=Depth; Quit".
+// Failures are logged as errors.
+static FAutoConsoleCommand GSeuratBenchmarkCommand(
+	TEXT("Seurat.Benchmark"),
+	TEXT("Runs the Seurat capture code benchmarks. Takes the options of the SeuratBenchmark commandlet."),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		FSeuratBenchmarkOptions Options;
+		const FString CommandLine = TEXT(" ") + FString::Join(Args, TEXT(" "));
+		ParseSeuratBenchmarkOptions(*CommandLine, Options);
+		RunSeuratBenchmarkSuite(Options);
+	}));
@@ -0,0 +1,340 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratBinaryManifest.h"
+#include "SeuratCore.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static const uint8 kBinaryManifestMagic[4] = { 'S', 'M', 'N', 'F' };
+static const uint32 kBinaryManifestVersion = 1;
+static const int64 kSectionAlignment = 16;
+
+static void WriteMatrix(const FMatrix& Matrix, float* OutElements)
+{
+	// Same element order as WriteMatrixJson.
+	for (int32 i = 0; i < 4; i++)
+		for (int32 j = 0; j < 4; j++)
+		{
+			OutElements[i * 4 + j] = Matrix.M[j][i];
+		}
+}
+
+static FMatrix ReadMatrix(const float* Elements)
+{
+	FMatrix Matrix;
+	for (int32 i = 0; i < 4; i++)
+		for (int32 j = 0; j < 4; j++)
+		{
+			Matrix.M[j][i] = Elements[i * 4 + j];
+		}
+	return Matrix;
+}
+
+FSeuratBinaryManifestBuilder::FSeuratBinaryManifestBuilder()
+{
+	Reset();
+}
+
+void FSeuratBinaryManifestBuilder::Reset()
+{
+	ViewGroups.Empty();
+	Views.Empty();
+	CulledFaces.Empty();
+	StringOffsets.Empty();
+	// Offset 0 is the empty string.
+	StringTable.Empty();
+	StringTable.Add('\0');
+	StringOffsets.Add(FString(), 0);
+	PackPath = 0;
+}
+
+void FSeuratBinaryManifestBuilder::SetPackPath(const FString& InPackPath)
+{
+	PackPath = AddString(InPackPath);
+}
+
+uint32 FSeuratBinaryManifestBuilder::AddString(const FString& String)
+{
+	if (const uint32* Offset = StringOffsets.Find(String))
+	{
+		return *Offset;
+	}
+	const uint32 Offset = StringTable.Num();
+	FTCHARToUTF8 Utf8String(*String);
+	StringTable.Append(Utf8String.Get(), Utf8String.Length());
+	StringTable.Add('\0');
+	StringOffsets.Add(String, Offset);
+	return Offset;
+}
+
+void FSeuratBinaryManifestBuilder::AddViewGroup(const TArray<SeuratView>& InViews, const TArray<SeuratCulledFace>& InCulledFaces)
+{
+	FSeuratBinaryViewGroup& Group = ViewGroups[ViewGroups.AddUninitialized()];
+	Group.FirstView = Views.Num();
+	Group.NumViews = InViews.Num();
+	Group.FirstCulledFace = CulledFaces.Num();
+	Group.NumCulledFaces = InCulledFaces.Num();
+
+	for (const SeuratView& InView : InViews)
+	{
+		FSeuratBinaryView& View = Views[Views.AddZeroed()];
+		View.ImageWidth = InView.ProjectiveCamera.ImageWidth;
+		View.ImageHeight = InView.ProjectiveCamera.ImageHeight;
+		WriteMatrix(InView.ProjectiveCamera.ClipFromEyeMatrix, View.ClipFromEyeMatrix);
+		WriteMatrix(InView.ProjectiveCamera.WorldFromEyeMatrix, View.WorldFromEyeMatrix);
+		View.DepthType = AddString(InView.ProjectiveCamera.DepthType);
+		View.ColorPath = AddString(InView.DepthImageFile.Color.Path);
+		View.ColorChannels[0] = AddString(InView.DepthImageFile.Color.Channel0);
+		View.ColorChannels[1] = AddString(InView.DepthImageFile.Color.Channel1);
+		View.ColorChannels[2] = AddString(InView.DepthImageFile.Color.Channel2);
+		View.ColorChannels[3] = AddString(InView.DepthImageFile.Color.ChannelAlpha);
+		View.DepthPath = AddString(InView.DepthImageFile.Depth.Path);
+		View.DepthChannel0 = AddString(InView.DepthImageFile.Depth.Channel0);
+		View.ViewGroup = ViewGroups.Num() - 1;
+		View.ColorPackOffset = InView.DepthImageFile.Color.Pack.Offset;
+		View.ColorPackSize = InView.DepthImageFile.Color.Pack.Size;
+		View.DepthPackOffset = InView.DepthImageFile.Depth.Pack.Offset;
+		View.DepthPackSize = InView.DepthImageFile.Depth.Pack.Size;
+	}
+	for (const SeuratCulledFace& InCulledFace : InCulledFaces)
+	{
+		FSeuratBinaryCulledFace& CulledFace = CulledFaces[CulledFaces.AddUninitialized()];
+		CulledFace.Face = AddString(InCulledFace.Face);
+		CulledFace.Reason = AddString(InCulledFace.Reason);
+	}
+}
+
+template <typename T>
+static uint64 AppendSection(TArray<uint8>& Data, const TArray<T>& Section)
+{
+	Data.AddZeroed(Align(Data.Num(), kSectionAlignment) - Data.Num());
+	const uint64 Offset = Data.Num();
+	Data.Append(reinterpret_cast<const uint8*>(Section.GetData()), Section.Num() * sizeof(T));
+	return Offset;
+}
+
+void FSeuratBinaryManifestBuilder::Serialize(TArray<uint8>& OutData) const
+{
+	FSeuratBinaryManifestHeader Header;
+	FMemory::Memzero(Header);
+	FMemory::Memcpy(Header.Magic, kBinaryManifestMagic, sizeof(Header.Magic));
+	Header.Version = kBinaryManifestVersion;
+	Header.NumViewGroups = ViewGroups.Num();
+	Header.NumViews = Views.Num();
+	Header.NumCulledFaces = CulledFaces.Num();
+	Header.StringTableSize = StringTable.Num();
+	Header.PackPath = PackPath;
+
+	OutData.Reset();
+	OutData.AddZeroed(sizeof(Header));
+	Header.ViewGroupsOffset = AppendSection(OutData, ViewGroups);
+	Header.ViewsOffset = AppendSection(OutData, Views);
+	Header.CulledFacesOffset = AppendSection(OutData, CulledFaces);
+	Header.StringTableOffset = AppendSection(OutData, StringTable);
+	FMemory::Memcpy(OutData.GetData(), &Header, sizeof(Header));
+}
+
+bool FSeuratBinaryManifestBuilder::Save(const FString& Filename) const
+{
+	TArray<uint8> Data;
+	Serialize(Data);
+	if (!FFileHelper::SaveArrayToFile(Data, *Filename))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot write binary manifest %s."), *Filename);
+		return false;
+	}
+	return true;
+}
+
+FSeuratBinaryManifest::FSeuratBinaryManifest()
+	: Header(nullptr), ViewGroups(nullptr), Views(nullptr), CulledFaces(nullptr), StringTable(nullptr)
+{
+}
+
+// Whether |Count| records of |RecordSize| at |Offset| lie within the data.
+static bool IsSectionInBounds(uint64 Offset, uint64 Count, uint64 RecordSize, int64 DataSize)
+{
+	return Offset % kSectionAlignment == 0 && Offset <= static_cast<uint64>(DataSize) && Count <= (DataSize - Offset) / RecordSize;
+}
+
+bool FSeuratBinaryManifest::Initialize(const uint8* InData, int64 InDataSize)
+{
+	Header = nullptr;
+	if (InDataSize < static_cast<int64>(sizeof(FSeuratBinaryManifestHeader)) || !IsAligned(InData, 8))
+	{
+		return false;
+	}
+	const FSeuratBinaryManifestHeader* NewHeader = reinterpret_cast<const FSeuratBinaryManifestHeader*>(InData);
+	if (FMemory::Memcmp(NewHeader->Magic, kBinaryManifestMagic, sizeof(NewHeader->Magic)) != 0 || NewHeader->Version != kBinaryManifestVersion
+		|| NewHeader->NumViewGroups > MAX_int32 || NewHeader->NumViews > MAX_int32 || NewHeader->NumCulledFaces > MAX_int32
+		|| !IsSectionInBounds(NewHeader->ViewGroupsOffset, NewHeader->NumViewGroups, sizeof(FSeuratBinaryViewGroup), InDataSize)
+		|| !IsSectionInBounds(NewHeader->ViewsOffset, NewHeader->NumViews, sizeof(FSeuratBinaryView), InDataSize)
+		|| !IsSectionInBounds(NewHeader->CulledFacesOffset, NewHeader->NumCulledFaces, sizeof(FSeuratBinaryCulledFace), InDataSize)
+		|| !IsSectionInBounds(NewHeader->StringTableOffset, NewHeader->StringTableSize, 1, InDataSize)
+		|| NewHeader->StringTableSize == 0 || InData[NewHeader->StringTableOffset + NewHeader->StringTableSize - 1] != '\0')
+	{
+		return false;
+	}
+
+	Header = NewHeader;
+	ViewGroups = reinterpret_cast<const FSeuratBinaryViewGroup*>(InData + Header->ViewGroupsOffset);
+	Views = reinterpret_cast<const FSeuratBinaryView*>(InData + Header->ViewsOffset);
+	CulledFaces = reinterpret_cast<const FSeuratBinaryCulledFace*>(InData + Header->CulledFacesOffset);
+	StringTable = reinterpret_cast<const ANSICHAR*>(InData + Header->StringTableOffset);
+	return true;
+}
+
+bool FSeuratBinaryManifest::Load(const FString& Filename)
+{
+	Header = nullptr;
+	if (!FFileHelper::LoadFileToArray(OwnedData, *Filename))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot read binary manifest %s."), *Filename);
+		return false;
+	}
+	if (!Initialize(OwnedData.GetData(), OwnedData.Num()))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("%s is not a valid binary manifest."), *Filename);
+		return false;
+	}
+	return true;
+}
+
+const FSeuratBinaryViewGroup& FSeuratBinaryManifest::GetViewGroup(int32 GroupIndex) const
+{
+	check(GroupIndex >= 0 && GroupIndex < GetNumViewGroups());
+	return ViewGroups[GroupIndex];
+}
+
+const FSeuratBinaryView& FSeuratBinaryManifest::GetView(int32 ViewIndex) const
+{
+	check(ViewIndex >= 0 && ViewIndex < GetNumViews());
+	return Views[ViewIndex];
+}
+
+const FSeuratBinaryCulledFace& FSeuratBinaryManifest::GetCulledFace(int32 CulledFaceIndex) const
+{
+	check(Header != nullptr && CulledFaceIndex >= 0 && CulledFaceIndex < static_cast<int32>(Header->NumCulledFaces));
+	return CulledFaces[CulledFaceIndex];
+}
+
+const ANSICHAR* FSeuratBinaryManifest::GetString(uint32 Offset) const
+{
+	// The table ends with a null, so every offset within it is a valid string.
+	return Header != nullptr && Offset < Header->StringTableSize ? StringTable + Offset : "";
+}
+
+SeuratView FSeuratBinaryManifest::ToSeuratView(int32 ViewIndex) const
+{
+	const FSeuratBinaryView& BinaryView = GetView(ViewIndex);
+	SeuratView View;
+	View.ProjectiveCamera.ImageWidth = BinaryView.ImageWidth;
+	View.ProjectiveCamera.ImageHeight = BinaryView.ImageHeight;
+	View.ProjectiveCamera.ClipFromEyeMatrix = ReadMatrix(BinaryView.ClipFromEyeMatrix);
+	View.ProjectiveCamera.WorldFromEyeMatrix = ReadMatrix(BinaryView.WorldFromEyeMatrix);
+	View.ProjectiveCamera.DepthType = UTF8_TO_TCHAR(GetString(BinaryView.DepthType));
+	View.DepthImageFile.Color.Path = UTF8_TO_TCHAR(GetString(BinaryView.ColorPath));
+	View.DepthImageFile.Color.Channel0 = UTF8_TO_TCHAR(GetString(BinaryView.ColorChannels[0]));
+	View.DepthImageFile.Color.Channel1 = UTF8_TO_TCHAR(GetString(BinaryView.ColorChannels[1]));
+	View.DepthImageFile.Color.Channel2 = UTF8_TO_TCHAR(GetString(BinaryView.ColorChannels[2]));
+	View.DepthImageFile.Color.ChannelAlpha = UTF8_TO_TCHAR(GetString(BinaryView.ColorChannels[3]));
+	View.DepthImageFile.Depth.Path = UTF8_TO_TCHAR(GetString(BinaryView.DepthPath));
+	View.DepthImageFile.Depth.Channel0 = UTF8_TO_TCHAR(GetString(BinaryView.DepthChannel0));
+	View.DepthImageFile.Color.Pack.Offset = BinaryView.ColorPackOffset;
+	View.DepthImageFile.Color.Pack.Size = BinaryView.ColorPackSize;
+	View.DepthImageFile.Depth.Pack.Offset = BinaryView.DepthPackOffset;
+	View.DepthImageFile.Depth.Pack.Size = BinaryView.DepthPackSize;
+	return View;
+}
+
+void FSeuratBinaryManifest::ReadViewGroup(int32 GroupIndex, TArray<SeuratView>& OutViews, TArray<SeuratCulledFace>& OutCulledFaces) const
+{
+	const FSeuratBinaryViewGroup& Group = GetViewGroup(GroupIndex);
+	// Group ranges are not checked on open, so clamp them here.
+	const uint32 EndView = static_cast<uint32>(FMath::Min<uint64>(static_cast<uint64>(Group.FirstView) + Group.NumViews, Header->NumViews));
+	OutViews.Empty(Group.NumViews);
+	for (uint32 ViewIndex = Group.FirstView; ViewIndex < EndView; ++ViewIndex)
+	{
+		OutViews.Add(ToSeuratView(ViewIndex));
+	}
+	const uint32 EndCulledFace = static_cast<uint32>(FMath::Min<uint64>(static_cast<uint64>(Group.FirstCulledFace) + Group.NumCulledFaces, Header->NumCulledFaces));
+	OutCulledFaces.Empty(Group.NumCulledFaces);
+	for (uint32 CulledFaceIndex = Group.FirstCulledFace; CulledFaceIndex < EndCulledFace; ++CulledFaceIndex)
+	{
+		SeuratCulledFace& CulledFace = OutCulledFaces[OutCulledFaces.AddDefaulted()];
+		CulledFace.Face = UTF8_TO_TCHAR(GetString(CulledFaces[CulledFaceIndex].Face));
+		CulledFace.Reason = UTF8_TO_TCHAR(GetString(CulledFaces[CulledFaceIndex].Reason));
+	}
+}
+
+static bool IsBinaryManifestFilename(const FString& Filename)
+{
+	return FPaths::GetExtension(Filename) == SEURAT_BINARY_MANIFEST_EXTENSION;
+}
+
+bool ConvertSeuratManifest(const FString& InputFilename, const FString& OutputFilename, bool bCompactJson)
+{
+	TArray<FSeuratManifestViewGroup> ViewGroups;
+	FString PackPath;
+	if (IsBinaryManifestFilename(InputFilename))
+	{
+		FSeuratBinaryManifest Input;
+		if (!Input.Load(InputFilename))
+		{
+			return false;
+		}
+		PackPath = UTF8_TO_TCHAR(Input.GetPackPath());
+		ViewGroups.SetNum(Input.GetNumViewGroups());
+		for (int32 GroupIndex = 0; GroupIndex < ViewGroups.Num(); ++GroupIndex)
+		{
+			Input.ReadViewGroup(GroupIndex, ViewGroups[GroupIndex].Views, ViewGroups[GroupIndex].CulledFaces);
+		}
+	}
+	else if (!ReadSeuratManifest(InputFilename, ViewGroups, &PackPath))
+	{
+		return false;
+	}
+	return WriteSeuratManifest(OutputFilename, ViewGroups, PackPath, bCompactJson);
+}
+
+bool WriteSeuratManifest(const FString& Filename, const TArray<FSeuratManifestViewGroup>& ViewGroups, const FString& PackPath, bool bCompactJson)
+{
+	if (IsBinaryManifestFilename(Filename))
+	{
+		FSeuratBinaryManifestBuilder Output;
+		Output.SetPackPath(PackPath);
+		for (const FSeuratManifestViewGroup& ViewGroup : ViewGroups)
+		{
+			Output.AddViewGroup(ViewGroup.Views, ViewGroup.CulledFaces);
+		}
+		return Output.Save(Filename);
+	}
+
+	FSeuratManifestWriter Output;
+	if (!Output.Open(Filename, bCompactJson, PackPath))
+	{
+		return false;
+	}
+	for (const FSeuratManifestViewGroup& ViewGroup : ViewGroups)
+	{
+		if (!Output.AppendViewGroup(ViewGroup.Views, ViewGroup.CulledFaces))
+		{
+			return false;
+		}
+	}
+	Output.Close();
+	return true;
+}
@@ -0,0 +1,113 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratCaptureReport.h"
+#include "SeuratCore.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonWriter.h"
+
+FSeuratCaptureReport::FSeuratCaptureReport() : StartTime(0.0), EndTime(0.0)
+{
+}
+
+void FSeuratCaptureReport::Begin()
+{
+	Views.Empty();
+	ViewIndices.Empty();
+	StartTime = FPlatformTime::Seconds();
+	EndTime = StartTime;
+}
+
+void FSeuratCaptureReport::End()
+{
+	EndTime = FPlatformTime::Seconds();
+}
+
+FSeuratViewTiming& FSeuratCaptureReport::FindOrAddView(const FString& Path)
+{
+	const int32* ViewIndex = ViewIndices.Find(Path);
+	if (ViewIndex != nullptr)
+	{
+		return Views[*ViewIndex];
+	}
+	const int32 NewIndex = Views.AddDefaulted();
+	Views[NewIndex].Path = Path;
+	ViewIndices.Add(Path, NewIndex);
+	return Views[NewIndex];
+}
+
+int64 FSeuratCaptureReport::GetBytesWritten() const
+{
+	int64 BytesWritten = 0;
+	for (const FSeuratViewTiming& View : Views)
+	{
+		BytesWritten += View.BytesWritten;
+	}
+	return BytesWritten;
+}
+
+bool FSeuratCaptureReport::Save(const FString& Filename) const
+{
+	FSeuratViewTiming Total;
+	for (const FSeuratViewTiming& View : Views)
+	{
+		Total.IssueSeconds += View.IssueSeconds;
+		Total.ReadbackSeconds += View.ReadbackSeconds;
+		Total.EncodeSeconds += View.EncodeSeconds;
+		Total.WriteSeconds += View.WriteSeconds;
+		Total.BytesWritten += View.BytesWritten;
+	}
+	const double TotalSeconds = FMath::Max(GetTotalSeconds(), SMALL_NUMBER);
+
+	FString Text;
+	TSharedRef<TJsonWriter<TCHAR>> Writer = TJsonWriterFactory<TCHAR>::Create(&Text);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("num_views"), Views.Num());
+	Writer->WriteValue(TEXT("total_seconds"), TotalSeconds);
+	Writer->WriteValue(TEXT("bytes_written"), static_cast<double>(Total.BytesWritten));
+	Writer->WriteValue(TEXT("views_per_second"), Views.Num() / TotalSeconds);
+	Writer->WriteValue(TEXT("megabytes_per_second"), Total.BytesWritten / (1024.0 * 1024.0) / TotalSeconds);
+	// Stage totals are summed over views; encode and write run on several
+	// threads, so they may exceed the capture time.
+	Writer->WriteObjectStart(TEXT("stage_seconds"));
+	Writer->WriteValue(TEXT("issue"), Total.IssueSeconds);
+	Writer->WriteValue(TEXT("readback"), Total.ReadbackSeconds);
+	Writer->WriteValue(TEXT("encode"), Total.EncodeSeconds);
+	Writer->WriteValue(TEXT("write"), Total.WriteSeconds);
+	Writer->WriteObjectEnd();
+	Writer->WriteArrayStart(TEXT("views"));
+	for (const FSeuratViewTiming& View : Views)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("path"), View.Path);
+		Writer->WriteValue(TEXT("issue_seconds"), View.IssueSeconds);
+		Writer->WriteValue(TEXT("readback_seconds"), View.ReadbackSeconds);
+		Writer->WriteValue(TEXT("encode_seconds"), View.EncodeSeconds);
+		Writer->WriteValue(TEXT("write_seconds"), View.WriteSeconds);
+		Writer->WriteValue(TEXT("bytes_written"), static_cast<double>(View.BytesWritten));
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	if (!FFileHelper::SaveStringToFile(Text, *Filename))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot write capture report %s."), *Filename);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,81 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratCaptureScheduler.h"
+
+FSeuratCaptureScheduler::FSeuratCaptureScheduler() : NextJob(0), NumRetired(0), MaxJobsPerTick(1), MaxJobsInFlight(1)
+{
+}
+
+void FSeuratCaptureScheduler::Reset(int32 NumSamples, int32 NumSides, int32 InMaxJobsPerTick, int32 InMaxJobsInFlight, const TArray<int32>& SampleTileCounts)
+{
+	check(SampleTileCounts.Num() == 0 || SampleTileCounts.Num() == NumSamples);
+	Jobs.Empty(NumSamples * NumSides);
+	for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+	{
+		const int32 NumTiles = SampleTileCounts.Num() > 0 ? FMath::Max(SampleTileCounts[SampleIndex], 1) : 1;
+		for (int32 SideIndex = 0; SideIndex < NumSides; ++SideIndex)
+		{
+			// The tiles of a view are issued together, so its image is finished
+			// before the next view starts.
+			for (int32 TileIndex = 0; TileIndex < NumTiles; ++TileIndex)
+			{
+				Jobs.Add(FSeuratCaptureJob(SampleIndex, SideIndex, TileIndex));
+			}
+		}
+	}
+	InFlight.Empty();
+	NextJob = 0;
+	NumRetired = 0;
+	MaxJobsPerTick = FMath::Max(InMaxJobsPerTick, 1);
+	MaxJobsInFlight = FMath::Max(InMaxJobsInFlight, 1);
+}
+
+int32 FSeuratCaptureScheduler::RemoveJobs(TFunctionRef<bool(const FSeuratCaptureJob&)> IsDone)
+{
+	check(NextJob == 0);
+	return Jobs.RemoveAll([&IsDone](const FSeuratCaptureJob& Job) { return IsDone(Job); });
+}
+
+int32 FSeuratCaptureScheduler::Tick(TFunctionRef<bool()> CanIssue, TFunctionRef<TSharedRef<ISeuratCaptureFence>(const FSeuratCaptureJob&)> Issue)
+{
+	RetireCompletedJobs();
+
+	int32 NumIssued = 0;
+	while (NextJob < Jobs.Num() && NumIssued < MaxJobsPerTick && InFlight.Num() < MaxJobsInFlight && CanIssue())
+	{
+		InFlight.Add(Issue(Jobs[NextJob]));
+		++NextJob;
+		++NumIssued;
+	}
+	return NumIssued;
+}
+
+bool FSeuratCaptureScheduler::IsComplete() const
+{
+	return NumRetired == Jobs.Num();
+}
+
+void FSeuratCaptureScheduler::RetireCompletedJobs()
+{
+	// The renderer executes jobs in issue order, so fences signal in order too.
+	int32 NumCompleted = 0;
+	while (NumCompleted < InFlight.Num() && InFlight[NumCompleted]->IsComplete())
+	{
+		++NumCompleted;
+	}
+	InFlight.RemoveAt(0, NumCompleted, false);
+	NumRetired += NumCompleted;
+}
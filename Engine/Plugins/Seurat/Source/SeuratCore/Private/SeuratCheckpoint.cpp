@@ -0,0 +1,145 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratCheckpoint.h"
+#include "SeuratCore.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// Identifies the file format in the header line; bump on incompatible changes.
+static const TCHAR* kCheckpointHeader = TEXT("SeuratCheckpoint1");
+
+FSeuratCaptureCheckpoint::FSeuratCaptureCheckpoint() : SettingsHash(0)
+{
+}
+
+FSeuratCaptureCheckpoint::~FSeuratCaptureCheckpoint()
+{
+	Close();
+}
+
+uint32 FSeuratCaptureCheckpoint::HashSettings(const FTransform& CameraTransform, const FVector& HeadboxSize, int32 Resolution, int32 NumSamples, int32 CaptureMode,
+	int32 SamplePattern, uint32 SampleSeed)
+{
+	const FVector Location = CameraTransform.GetLocation();
+	const FQuat Rotation = CameraTransform.GetRotation();
+	const FVector Scale = CameraTransform.GetScale3D();
+	const float Settings[] = {
+		Location.X, Location.Y, Location.Z,
+		Rotation.X, Rotation.Y, Rotation.Z, Rotation.W,
+		Scale.X, Scale.Y, Scale.Z,
+		HeadboxSize.X, HeadboxSize.Y, HeadboxSize.Z,
+	};
+	const int32 Counts[] = { Resolution, NumSamples, CaptureMode };
+	const uint32 Hash = FCrc::MemCrc32(Counts, sizeof(Counts), FCrc::MemCrc32(Settings, sizeof(Settings)));
+	if (SamplePattern == 0 && SampleSeed == 0)
+	{
+		return Hash;
+	}
+	const uint32 Pattern[] = { static_cast<uint32>(SamplePattern), SampleSeed };
+	return FCrc::MemCrc32(Pattern, sizeof(Pattern), Hash);
+}
+
+bool FSeuratCaptureCheckpoint::Open(const FString& InFilename, uint32 InSettingsHash)
+{
+	Close();
+	Filename = InFilename;
+	SettingsHash = InSettingsHash;
+	CompletedImages.Empty();
+
+	const FString Header = FString::Printf(TEXT("%s %08x"), kCheckpointHeader, SettingsHash);
+	const FString Directory = FPaths::GetPath(Filename);
+	TArray<FString> Lines;
+	if (FFileHelper::LoadFileToStringArray(Lines, *Filename) && Lines.Num() > 0 && Lines[0] == Header)
+	{
+		for (int32 LineIndex = 1; LineIndex < Lines.Num(); ++LineIndex)
+		{
+			// A crash may have truncated the last record, which then fails to
+			// match the size of its image.
+			FString SizeText;
+			FString ImageName;
+			if (!Lines[LineIndex].Split(TEXT(" "), &SizeText, &ImageName))
+			{
+				continue;
+			}
+			const int64 SizeBytes = FCString::Atoi64(*SizeText);
+			if (SizeBytes > 0 && IFileManager::Get().FileSize(*(Directory / ImageName)) == SizeBytes)
+			{
+				CompletedImages.Add(ImageName, SizeBytes);
+			}
+		}
+	}
+
+	// Rewrite the file rather than append to it, so stale and truncated records
+	// are dropped.
+	Archive.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Archive.IsValid() || !WriteLine(Header))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot write capture checkpoint %s."), *Filename);
+		Close();
+		return false;
+	}
+	for (const TPair<FString, int64>& Image : CompletedImages)
+	{
+		WriteLine(FString::Printf(TEXT("%lld %s"), Image.Value, *Image.Key));
+	}
+	Archive->Flush();
+	return true;
+}
+
+void FSeuratCaptureCheckpoint::Close()
+{
+	if (Archive.IsValid())
+	{
+		Archive->Close();
+		Archive.Reset();
+	}
+}
+
+void FSeuratCaptureCheckpoint::Delete()
+{
+	Close();
+	if (!Filename.IsEmpty())
+	{
+		IFileManager::Get().Delete(*Filename);
+	}
+	CompletedImages.Empty();
+}
+
+bool FSeuratCaptureCheckpoint::IsImageComplete(const FString& ImageFilename) const
+{
+	const int64* SizeBytes = CompletedImages.Find(FPaths::GetCleanFilename(ImageFilename));
+	return SizeBytes != nullptr && IFileManager::Get().FileSize(*ImageFilename) == *SizeBytes;
+}
+
+void FSeuratCaptureCheckpoint::MarkImageComplete(const FString& ImageFilename, int64 SizeBytes)
+{
+	if (!Archive.IsValid())
+	{
+		return;
+	}
+	const FString ImageName = FPaths::GetCleanFilename(ImageFilename);
+	CompletedImages.Add(ImageName, SizeBytes);
+	WriteLine(FString::Printf(TEXT("%lld %s"), SizeBytes, *ImageName));
+	Archive->Flush();
+}
+
+bool FSeuratCaptureCheckpoint::WriteLine(const FString& Line)
+{
+	FTCHARToUTF8 Utf8Line(*(Line + LINE_TERMINATOR));
+	Archive->Serialize(const_cast<ANSICHAR*>(Utf8Line.Get()), Utf8Line.Length());
+	return !Archive->IsError();
+}
@@ -0,0 +1,427 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratDepthCodec.h"
+
+#define SEURAT_DEPTH_CODEC_SSE2 (PLATFORM_ENABLE_VECTORINTRINSICS && !PLATFORM_ENABLE_VECTORINTRINSICS_NEON)
+
+#if SEURAT_DEPTH_CODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const uint8 kDepthMagic[4] = { 'S', 'D', 'P', 'T' };
+	const uint8 kDepthVersion = 1;
+	const int32 kHeaderSize = 16;
+	// Residuals per Rice parameter.
+	const int32 kBlockSize = 64;
+	const int32 kRiceParameterBits = 5;
+	// Quotients of this many bits or more are escaped and stored verbatim.
+	const uint32 kEscapeLength = 24;
+
+	// Maps float bit patterns to integers that order like the floats, so that
+	// neighboring depths have nearby integers. The mapping is its own inverse.
+	FORCEINLINE uint32 OrderFloatBits(uint32 Bits)
+	{
+		return Bits ^ (static_cast<uint32>(static_cast<int32>(Bits) >> 31) & 0x7fffffffu);
+	}
+
+	FORCEINLINE uint32 ZigZag(uint32 Residual)
+	{
+		return (Residual << 1) ^ static_cast<uint32>(static_cast<int32>(Residual) >> 31);
+	}
+
+	FORCEINLINE uint32 UnZigZag(uint32 Value)
+	{
+		return (Value >> 1) ^ (0u - (Value & 1));
+	}
+
+	// Median edge detector of LOCO-I on ordered integers. Arithmetic wraps, so
+	// residuals round trip exactly whatever their magnitude.
+	FORCEINLINE uint32 PredictMed(uint32 W, uint32 N, uint32 NW)
+	{
+		const int32 A = static_cast<int32>(W);
+		const int32 B = static_cast<int32>(N);
+		const int32 C = static_cast<int32>(NW);
+		const int32 Min = FMath::Min(A, B);
+		const int32 Max = FMath::Max(A, B);
+		if (C >= Max)
+		{
+			return static_cast<uint32>(Min);
+		}
+		if (C <= Min)
+		{
+			return static_cast<uint32>(Max);
+		}
+		return W + N - NW;
+	}
+
+	void OrderAndShift(const uint32* Bits, uint32* OutValues, int32 NumValues, int32 Shift)
+	{
+		int32 Index = 0;
+#if SEURAT_DEPTH_CODEC_SSE2
+		const __m128i LowMask = _mm_set1_epi32(0x7fffffff);
+		const __m128i ShiftCount = _mm_cvtsi32_si128(Shift);
+		for (; Index + 4 <= NumValues; Index += 4)
+		{
+			const __m128i Value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Bits + Index));
+			const __m128i Ordered = _mm_xor_si128(Value, _mm_and_si128(_mm_srai_epi32(Value, 31), LowMask));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutValues + Index), _mm_sra_epi32(Ordered, ShiftCount));
+		}
+#endif
+		for (; Index < NumValues; ++Index)
+		{
+			OutValues[Index] = static_cast<uint32>(static_cast<int32>(OrderFloatBits(Bits[Index])) >> Shift);
+		}
+	}
+
+	void UnshiftAndUnorder(const uint32* Values, uint32* OutBits, int32 NumValues, int32 Shift)
+	{
+		int32 Index = 0;
+#if SEURAT_DEPTH_CODEC_SSE2
+		const __m128i LowMask = _mm_set1_epi32(0x7fffffff);
+		const __m128i ShiftCount = _mm_cvtsi32_si128(Shift);
+		for (; Index + 4 <= NumValues; Index += 4)
+		{
+			const __m128i Ordered = _mm_sll_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Values + Index)), ShiftCount);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutBits + Index), _mm_xor_si128(Ordered, _mm_and_si128(_mm_srai_epi32(Ordered, 31), LowMask)));
+		}
+#endif
+		for (; Index < NumValues; ++Index)
+		{
+			OutBits[Index] = OrderFloatBits(Values[Index] << Shift);
+		}
+	}
+
+	// Computes the zigzagged residuals of a row below the first. Every
+	// neighbor is known up front, so the encoder predicts four pixels at once.
+	void EncodeRowResiduals(const uint32* Row, const uint32* PreviousRow, uint32* OutResiduals, int32 Width)
+	{
+		OutResiduals[0] = ZigZag(Row[0] - PreviousRow[0]);
+		int32 X = 1;
+#if SEURAT_DEPTH_CODEC_SSE2
+		for (; X + 4 <= Width; X += 4)
+		{
+			const __m128i W = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Row + X - 1));
+			const __m128i N = _mm_loadu_si128(reinterpret_cast<const __m128i*>(PreviousRow + X));
+			const __m128i NW = _mm_loadu_si128(reinterpret_cast<const __m128i*>(PreviousRow + X - 1));
+			// SSE2 has no 32 bit min and max, so select with comparisons.
+			const __m128i WGreater = _mm_cmpgt_epi32(W, N);
+			const __m128i Max = _mm_or_si128(_mm_and_si128(WGreater, W), _mm_andnot_si128(WGreater, N));
+			const __m128i Min = _mm_or_si128(_mm_and_si128(WGreater, N), _mm_andnot_si128(WGreater, W));
+			const __m128i Plane = _mm_sub_epi32(_mm_add_epi32(W, N), NW);
+			const __m128i AboveMin = _mm_cmpgt_epi32(NW, Min);
+			const __m128i Inner = _mm_or_si128(_mm_and_si128(AboveMin, Plane), _mm_andnot_si128(AboveMin, Max));
+			const __m128i BelowMax = _mm_cmpgt_epi32(Max, NW);
+			const __m128i Prediction = _mm_or_si128(_mm_and_si128(BelowMax, Inner), _mm_andnot_si128(BelowMax, Min));
+			const __m128i Residual = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Row + X)), Prediction);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutResiduals + X), _mm_xor_si128(_mm_slli_epi32(Residual, 1), _mm_srai_epi32(Residual, 31)));
+		}
+#endif
+		for (; X < Width; ++X)
+		{
+			OutResiduals[X] = ZigZag(Row[X] - PredictMed(Row[X - 1], PreviousRow[X], PreviousRow[X - 1]));
+		}
+	}
+
+	void UnZigZagResiduals(uint32* Values, int32 NumValues)
+	{
+		int32 Index = 0;
+#if SEURAT_DEPTH_CODEC_SSE2
+		const __m128i One = _mm_set1_epi32(1);
+		for (; Index + 4 <= NumValues; Index += 4)
+		{
+			const __m128i Value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Values + Index));
+			const __m128i Sign = _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(Value, One));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Values + Index), _mm_xor_si128(_mm_srli_epi32(Value, 1), Sign));
+		}
+#endif
+		for (; Index < NumValues; ++Index)
+		{
+			Values[Index] = UnZigZag(Values[Index]);
+		}
+	}
+
+	class FBitWriter
+	{
+	public:
+		explicit FBitWriter(TArray<uint8>& InData) : Data(InData), Accumulator(0), NumBits(0) {}
+
+		// Writes the low |Count| bits of |Value|, at most 32.
+		FORCEINLINE void Write(uint32 Value, int32 Count)
+		{
+			Accumulator |= static_cast<uint64>(Value) << NumBits;
+			NumBits += Count;
+			if (NumBits >= 32)
+			{
+				const uint32 Word = static_cast<uint32>(Accumulator);
+				const uint8 Bytes[4] = { static_cast<uint8>(Word), static_cast<uint8>(Word >> 8), static_cast<uint8>(Word >> 16), static_cast<uint8>(Word >> 24) };
+				Data.Append(Bytes, 4);
+				Accumulator >>= 32;
+				NumBits -= 32;
+			}
+		}
+
+		void Flush()
+		{
+			while (NumBits > 0)
+			{
+				Data.Add(static_cast<uint8>(Accumulator));
+				Accumulator >>= 8;
+				NumBits -= 8;
+			}
+			NumBits = 0;
+		}
+
+	private:
+		TArray<uint8>& Data;
+		uint64 Accumulator;
+		int32 NumBits;
+	};
+
+	class FBitReader
+	{
+	public:
+		FBitReader(const uint8* InData, int64 InSize) : Data(InData), Size(InSize), Position(0), Accumulator(0), NumBits(0), NumPaddingBits(0) {}
+
+		// Reads |Count| bits, at most 32.
+		FORCEINLINE uint32 Read(int32 Count)
+		{
+			Refill();
+			const uint32 Value = static_cast<uint32>(Accumulator & ((static_cast<uint64>(1) << Count) - 1));
+			Accumulator >>= Count;
+			NumBits -= Count;
+			return Value;
+		}
+
+		// Reads a unary code of up to |MaxLength| one bits. Returns MaxLength,
+		// consuming only the ones, if there is no terminating zero before.
+		FORCEINLINE uint32 ReadUnary(uint32 MaxLength)
+		{
+			Refill();
+			const uint32 Ones = FMath::CountTrailingZeros(~static_cast<uint32>(Accumulator));
+			const uint32 Length = FMath::Min(Ones, MaxLength);
+			const int32 Consumed = Length < MaxLength ? Length + 1 : MaxLength;
+			Accumulator >>= Consumed;
+			NumBits -= Consumed;
+			return Length;
+		}
+
+		// Whether reads went past the end of the data.
+		bool IsOverrun() const { return NumPaddingBits > 0 && NumBits < NumPaddingBits; }
+
+	private:
+		FORCEINLINE void Refill()
+		{
+			while (NumBits <= 56)
+			{
+				if (Position < Size)
+				{
+					Accumulator |= static_cast<uint64>(Data[Position++]) << NumBits;
+				}
+				else
+				{
+					NumPaddingBits += 8;
+				}
+				NumBits += 8;
+			}
+		}
+
+		const uint8* Data;
+		int64 Size;
+		int64 Position;
+		uint64 Accumulator;
+		int32 NumBits;
+		// Zero bits appended past the end of the data.
+		int32 NumPaddingBits;
+	};
+
+	void WriteUint32(uint8* Out, uint32 Value)
+	{
+		Out[0] = static_cast<uint8>(Value);
+		Out[1] = static_cast<uint8>(Value >> 8);
+		Out[2] = static_cast<uint8>(Value >> 16);
+		Out[3] = static_cast<uint8>(Value >> 24);
+	}
+
+	uint32 ReadUint32(const uint8* In)
+	{
+		return In[0] | (In[1] << 8) | (In[2] << 16) | (static_cast<uint32>(In[3]) << 24);
+	}
+}
+
+void EncodeSeuratDepth(const float* Depths, int32 Width, int32 Height, TArray<uint8>& OutData)
+{
+	check(Width >= 0 && Height >= 0 && static_cast<int64>(Width) * Height <= MAX_int32);
+	const int32 NumPixels = Width * Height;
+	// Images without pixels are stored as 0 x 0, the only empty size the
+	// decoder accepts.
+	if (NumPixels == 0)
+	{
+		Width = 0;
+		Height = 0;
+	}
+	const uint32* Bits = reinterpret_cast<const uint32*>(Depths);
+
+	// Drop the low bits that are zero in every ordered value.
+	uint32 UsedBits = 0;
+	for (int32 Index = 0; Index < NumPixels; ++Index)
+	{
+		UsedBits |= OrderFloatBits(Bits[Index]);
+	}
+	const int32 Shift = UsedBits != 0 ? FMath::Min<int32>(FMath::CountTrailingZeros(UsedBits), 31) : 0;
+
+	TArray<uint32> Values;
+	Values.SetNumUninitialized(NumPixels);
+	OrderAndShift(Bits, Values.GetData(), NumPixels, Shift);
+
+	TArray<uint32> Residuals;
+	Residuals.SetNumUninitialized(NumPixels);
+	if (NumPixels > 0)
+	{
+		Residuals[0] = ZigZag(Values[0]);
+		for (int32 X = 1; X < Width; ++X)
+		{
+			Residuals[X] = ZigZag(Values[X] - Values[X - 1]);
+		}
+		for (int32 Y = 1; Y < Height; ++Y)
+		{
+			EncodeRowResiduals(&Values[Y * Width], &Values[(Y - 1) * Width], &Residuals[Y * Width], Width);
+		}
+	}
+
+	OutData.Reset();
+	OutData.AddUninitialized(kHeaderSize);
+	FMemory::Memcpy(OutData.GetData(), kDepthMagic, 4);
+	OutData[4] = kDepthVersion;
+	OutData[5] = static_cast<uint8>(Shift);
+	OutData[6] = 0;
+	OutData[7] = 0;
+	WriteUint32(&OutData[8], Width);
+	WriteUint32(&OutData[12], Height);
+
+	FBitWriter Writer(OutData);
+	for (int32 BlockStart = 0; BlockStart < NumPixels; BlockStart += kBlockSize)
+	{
+		const int32 BlockEnd = FMath::Min(BlockStart + kBlockSize, NumPixels);
+		// The Rice parameter that best fits the mean residual of the block.
+		uint64 Sum = 0;
+		for (int32 Index = BlockStart; Index < BlockEnd; ++Index)
+		{
+			Sum += Residuals[Index];
+		}
+		const uint64 Count = BlockEnd - BlockStart;
+		uint32 Parameter = 0;
+		while (Parameter < 31 && (Count << Parameter) < Sum)
+		{
+			++Parameter;
+		}
+		Writer.Write(Parameter, kRiceParameterBits);
+
+		const uint32 LowMask = (1u << Parameter) - 1;
+		for (int32 Index = BlockStart; Index < BlockEnd; ++Index)
+		{
+			const uint32 Residual = Residuals[Index];
+			const uint32 Quotient = Residual >> Parameter;
+			if (Quotient < kEscapeLength)
+			{
+				// Quotient ones and a terminating zero.
+				Writer.Write((1u << Quotient) - 1, Quotient + 1);
+				Writer.Write(Residual & LowMask, Parameter);
+			}
+			else
+			{
+				Writer.Write((1u << kEscapeLength) - 1, kEscapeLength);
+				Writer.Write(Residual, 32);
+			}
+		}
+	}
+	Writer.Flush();
+}
+
+bool GetSeuratDepthSize(const uint8* Data, int64 DataSize, int32& OutWidth, int32& OutHeight)
+{
+	if (DataSize < kHeaderSize || FMemory::Memcmp(Data, kDepthMagic, 4) != 0 || Data[4] != kDepthVersion || Data[5] > 31)
+	{
+		return false;
+	}
+	const uint32 Width = ReadUint32(Data + 8);
+	const uint32 Height = ReadUint32(Data + 12);
+	// An image with no pixels must have neither rows nor columns, and the pixel
+	// count must fit the int32 indices of decoding. Every pixel takes at least
+	// one bit, which also bounds the allocation a malformed header can cause.
+	const uint64 NumPixels = static_cast<uint64>(Width) * Height;
+	if ((Width == 0) != (Height == 0) || NumPixels > static_cast<uint64>(MAX_int32) || NumPixels > static_cast<uint64>(DataSize - kHeaderSize) * 8)
+	{
+		return false;
+	}
+	OutWidth = Width;
+	OutHeight = Height;
+	return true;
+}
+
+bool DecodeSeuratDepth(const uint8* Data, int64 DataSize, TArray<float>& OutDepths, int32& OutWidth, int32& OutHeight)
+{
+	int32 Width = 0;
+	int32 Height = 0;
+	if (!GetSeuratDepthSize(Data, DataSize, Width, Height))
+	{
+		return false;
+	}
+	const int32 Shift = Data[5];
+	const int32 NumPixels = Width * Height;
+
+	TArray<uint32> Values;
+	Values.SetNumUninitialized(NumPixels);
+	FBitReader Reader(Data + kHeaderSize, DataSize - kHeaderSize);
+	for (int32 BlockStart = 0; BlockStart < NumPixels; BlockStart += kBlockSize)
+	{
+		const int32 BlockEnd = FMath::Min(BlockStart + kBlockSize, NumPixels);
+		const uint32 Parameter = Reader.Read(kRiceParameterBits);
+		for (int32 Index = BlockStart; Index < BlockEnd; ++Index)
+		{
+			const uint32 Quotient = Reader.ReadUnary(kEscapeLength);
+			Values[Index] = Quotient < kEscapeLength ? (Quotient << Parameter) | Reader.Read(Parameter) : Reader.Read(32);
+		}
+		if (Reader.IsOverrun())
+		{
+			return false;
+		}
+	}
+	UnZigZagResiduals(Values.GetData(), NumPixels);
+
+	// Prediction depends on the previous pixel, so reconstruction is serial.
+	for (int32 X = 1; X < Width; ++X)
+	{
+		Values[X] += Values[X - 1];
+	}
+	for (int32 Y = 1; Y < Height; ++Y)
+	{
+		uint32* Row = &Values[Y * Width];
+		const uint32* PreviousRow = Row - Width;
+		Row[0] += PreviousRow[0];
+		for (int32 X = 1; X < Width; ++X)
+		{
+			Row[X] += PredictMed(Row[X - 1], PreviousRow[X], PreviousRow[X - 1]);
+		}
+	}
+
+	OutDepths.SetNumUninitialized(NumPixels);
+	UnshiftAndUnorder(Values.GetData(), reinterpret_cast<uint32*>(OutDepths.GetData()), NumPixels, Shift);
+	OutWidth = Width;
+	OutHeight = Height;
+	return true;
+}
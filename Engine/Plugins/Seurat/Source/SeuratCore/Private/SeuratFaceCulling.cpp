@@ -0,0 +1,175 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratFaceCulling.h"
+
+const TCHAR* GetSeuratFaceCullName(ESeuratFaceCull Cull)
+{
+	switch (Cull)
+	{
+	case ESeuratFaceCull::Empty:
+		return TEXT("empty");
+	case ESeuratFaceCull::Redundant:
+		return TEXT("redundant");
+	default:
+		return TEXT("none");
+	}
+}
+
+FSeuratFaceDepthStats ComputeSeuratFaceDepthStats(const TArray<float>& Depths, float SkyDepth)
+{
+	FSeuratFaceDepthStats Stats;
+	Stats.MinDepth = SkyDepth;
+	int32 NumGeometryPixels = 0;
+	for (float Depth : Depths)
+	{
+		if (Depth < SkyDepth)
+		{
+			++NumGeometryPixels;
+			Stats.MinDepth = FMath::Min(Stats.MinDepth, Depth);
+		}
+	}
+	Stats.GeometryFraction = Depths.Num() > 0 ? static_cast<float>(NumGeometryPixels) / Depths.Num() : 0.0f;
+	return Stats;
+}
+
+namespace
+{
+	// Uniform grid over the samples, with about one sample per cell, in which
+	// the captured samples of a side are bucketed. A sample is only tested
+	// against captured samples in the cells within its parallax radius.
+	class FSampleGrid
+	{
+	public:
+		explicit FSampleGrid(const TArray<FVector>& Samples)
+		{
+			const FBox Bounds(Samples);
+			const FVector Extent = Bounds.GetSize();
+			const int32 CellsPerAxis = FMath::Max(FMath::CeilToInt(FMath::Pow(static_cast<float>(Samples.Num()), 1.0f / 3.0f)), 1);
+			const float CellSize = FMath::Max(Extent.GetMax() / CellsPerAxis, KINDA_SMALL_NUMBER);
+			Origin = Bounds.Min;
+			InvCellSize = 1.0f / CellSize;
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				Size[Axis] = FMath::Clamp(FMath::FloorToInt(Extent[Axis] * InvCellSize) + 1, 1, CellsPerAxis + 1);
+			}
+			Cells.SetNum(Size.X * Size.Y * Size.Z);
+		}
+
+		void Reset()
+		{
+			for (TArray<int32>& Cell : Cells)
+			{
+				Cell.Reset();
+			}
+		}
+
+		void Add(const FVector& Position, int32 SampleIndex)
+		{
+			const FIntVector Cell = GetCell(Position);
+			Cells[(Cell.Z * Size.Y + Cell.Y) * Size.X + Cell.X].Add(SampleIndex);
+		}
+
+		// Calls |Visit| with the samples in the cells that overlap the box of
+		// radius |Radius| around |Position| until it returns true.
+		bool AnyWithin(const FVector& Position, float Radius, TFunctionRef<bool(int32 SampleIndex)> Visit) const
+		{
+			const FIntVector Min = GetCell(Position - FVector(Radius));
+			const FIntVector Max = GetCell(Position + FVector(Radius));
+			for (int32 Z = Min.Z; Z <= Max.Z; ++Z)
+			{
+				for (int32 Y = Min.Y; Y <= Max.Y; ++Y)
+				{
+					for (int32 X = Min.X; X <= Max.X; ++X)
+					{
+						for (int32 SampleIndex : Cells[(Z * Size.Y + Y) * Size.X + X])
+						{
+							if (Visit(SampleIndex))
+							{
+								return true;
+							}
+						}
+					}
+				}
+			}
+			return false;
+		}
+
+	private:
+		FIntVector GetCell(const FVector& Position) const
+		{
+			// Clamped as floats first, so infinite radii stay in the grid.
+			FIntVector Cell;
+			for (int32 Axis = 0; Axis < 3; ++Axis)
+			{
+				const float Coordinate = FMath::Clamp((Position[Axis] - Origin[Axis]) * InvCellSize, 0.0f, static_cast<float>(Size[Axis] - 1));
+				Cell[Axis] = FMath::FloorToInt(Coordinate);
+			}
+			return Cell;
+		}
+
+		FVector Origin;
+		float InvCellSize;
+		FIntVector Size;
+		TArray<TArray<int32>> Cells;
+	};
+}
+
+void CullSeuratFaces(const TArray<FVector>& Samples, int32 NumSides, const TArray<FSeuratFaceDepthStats>& FaceStats,
+	const FSeuratFaceCullSettings& Settings, TArray<ESeuratFaceCull>& OutCulls)
+{
+	check(FaceStats.Num() == Samples.Num() * NumSides);
+	OutCulls.Init(ESeuratFaceCull::None, FaceStats.Num());
+	if (Samples.Num() == 0)
+	{
+		return;
+	}
+
+	// A 90 degree face has a focal length of half its resolution in pixels, so
+	// moving by D shifts content at depth Z by up to D / Z * Resolution / 2.
+	const float PixelsPerRadian = Settings.Resolution * 0.5f;
+	FSampleGrid CapturedSamples(Samples);
+	for (int32 Side = 0; Side < NumSides; ++Side)
+	{
+		CapturedSamples.Reset();
+		for (int32 SampleIndex = 0; SampleIndex < Samples.Num(); ++SampleIndex)
+		{
+			const FSeuratFaceDepthStats& Stats = FaceStats[SampleIndex * NumSides + Side];
+			ESeuratFaceCull& Cull = OutCulls[SampleIndex * NumSides + Side];
+			if (SampleIndex > 0 && Stats.GeometryFraction < Settings.MinGeometryFraction)
+			{
+				Cull = ESeuratFaceCull::Empty;
+				continue;
+			}
+			// The parallax test uses the nearer of both minimum depths, so no
+			// captured sample beyond this sample's own radius can pass it.
+			const float Radius = Settings.MaxParallaxPixels * FMath::Max(Stats.MinDepth, KINDA_SMALL_NUMBER) / FMath::Max(PixelsPerRadian, KINDA_SMALL_NUMBER);
+			const bool bRedundant = CapturedSamples.AnyWithin(Samples[SampleIndex], Radius, [&](int32 CapturedIndex)
+			{
+				const float MinDepth = FMath::Min(Stats.MinDepth, FaceStats[CapturedIndex * NumSides + Side].MinDepth);
+				const float Distance = FVector::Dist(Samples[SampleIndex], Samples[CapturedIndex]);
+				return Distance * PixelsPerRadian < Settings.MaxParallaxPixels * FMath::Max(MinDepth, KINDA_SMALL_NUMBER);
+			});
+			if (bRedundant)
+			{
+				Cull = ESeuratFaceCull::Redundant;
+			}
+			else
+			{
+				CapturedSamples.Add(Samples[SampleIndex], SampleIndex);
+			}
+		}
+	}
+}
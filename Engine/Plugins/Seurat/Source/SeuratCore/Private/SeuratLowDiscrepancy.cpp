@@ -0,0 +1,343 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratLowDiscrepancy.h"
+
+namespace
+{
+	const uint32 kHaltonBases[FSeuratLowDiscrepancySequence::kMaxDimensions] = { 2, 3, 5, 7, 11, 13, 17, 19 };
+
+	// Primitive polynomials and initial direction numbers of the Sobol
+	// dimensions after the first, from Joe and Kuo's new-joe-kuo-6.21201.
+	struct FSobolPolynomial
+	{
+		uint32 Degree;
+		uint32 Coefficients;
+		uint32 InitialNumbers[5];
+	};
+	const FSobolPolynomial kSobolPolynomials[FSeuratLowDiscrepancySequence::kMaxDimensions - 1] = {
+		{ 1, 0, { 1 } },
+		{ 2, 1, { 1, 3 } },
+		{ 3, 1, { 1, 3, 1 } },
+		{ 3, 2, { 1, 1, 1 } },
+		{ 4, 1, { 1, 1, 3, 3 } },
+		{ 4, 4, { 1, 3, 5, 13 } },
+		{ 5, 2, { 1, 1, 5, 5, 17 } },
+	};
+
+	// Direction numbers of each Sobol dimension, and their running XOR. Point
+	// I differs from point I - 1 in the direction numbers of the bits of
+	// I ^ (I - 1), which are the trailing zeros of I and the bit above them.
+	struct FSobolTables
+	{
+		uint32 Directions[FSeuratLowDiscrepancySequence::kMaxDimensions][32];
+		uint32 Steps[FSeuratLowDiscrepancySequence::kMaxDimensions][32];
+
+		FSobolTables()
+		{
+			for (int32 Bit = 0; Bit < 32; ++Bit)
+			{
+				Directions[0][Bit] = 1u << (31 - Bit);
+			}
+			for (int32 Dimension = 1; Dimension < FSeuratLowDiscrepancySequence::kMaxDimensions; ++Dimension)
+			{
+				const FSobolPolynomial& Polynomial = kSobolPolynomials[Dimension - 1];
+				uint32* V = Directions[Dimension];
+				for (uint32 Bit = 0; Bit < 32; ++Bit)
+				{
+					if (Bit < Polynomial.Degree)
+					{
+						V[Bit] = Polynomial.InitialNumbers[Bit] << (31 - Bit);
+						continue;
+					}
+					V[Bit] = V[Bit - Polynomial.Degree] ^ (V[Bit - Polynomial.Degree] >> Polynomial.Degree);
+					for (uint32 Term = 1; Term < Polynomial.Degree; ++Term)
+					{
+						if ((Polynomial.Coefficients >> (Polynomial.Degree - 1 - Term)) & 1)
+						{
+							V[Bit] ^= V[Bit - Term];
+						}
+					}
+				}
+			}
+			for (int32 Dimension = 0; Dimension < FSeuratLowDiscrepancySequence::kMaxDimensions; ++Dimension)
+			{
+				uint32 Step = 0;
+				for (int32 Bit = 0; Bit < 32; ++Bit)
+				{
+					Step ^= Directions[Dimension][Bit];
+					Steps[Dimension][Bit] = Step;
+				}
+			}
+		}
+	};
+
+	// Radical inverses of every number with ChunkDigits digits in a base, so
+	// the radical inverse of an index takes one lookup and division per chunk
+	// of digits rather than a division per digit.
+	struct FRadicalInverseTable
+	{
+		static const uint32 kMaxChunkSize = 1024;
+
+		uint32 Base;
+		uint32 ChunkSize;
+		double InvChunkSize;
+		TArray<double> Inverses;
+
+		explicit FRadicalInverseTable(uint32 InBase) : Base(InBase), ChunkSize(InBase)
+		{
+			while (ChunkSize * Base <= kMaxChunkSize)
+			{
+				ChunkSize *= Base;
+			}
+			InvChunkSize = 1.0 / ChunkSize;
+			Inverses.SetNumUninitialized(ChunkSize);
+			for (uint32 Value = 0; Value < ChunkSize; ++Value)
+			{
+				double Inverse = 0.0;
+				double Scale = 1.0 / Base;
+				for (uint32 Remaining = Value; Remaining != 0; Remaining /= Base)
+				{
+					Inverse += (Remaining % Base) * Scale;
+					Scale /= Base;
+				}
+				Inverses[Value] = Inverse;
+			}
+		}
+
+		double Evaluate(uint32 Index) const
+		{
+			double Result = 0.0;
+			double Scale = 1.0;
+			while (Index != 0)
+			{
+				Result += Inverses[Index % ChunkSize] * Scale;
+				Scale *= InvChunkSize;
+				Index /= ChunkSize;
+			}
+			return Result;
+		}
+	};
+
+	struct FRadicalInverseTables
+	{
+		TArray<FRadicalInverseTable> Tables;
+
+		FRadicalInverseTables()
+		{
+			for (uint32 Base : kHaltonBases)
+			{
+				Tables.Emplace(Base);
+			}
+		}
+	};
+
+	const FSobolTables& GetSobolTables()
+	{
+		static const FSobolTables Tables;
+		return Tables;
+	}
+
+	const FRadicalInverseTables& GetRadicalInverseTables()
+	{
+		static const FRadicalInverseTables Tables;
+		return Tables;
+	}
+
+	uint32 HashSeed(uint32 Value, uint32 Seed)
+	{
+		// Murmur3 finalizer.
+		uint32 Hash = Value ^ (Seed * 0x9e3779b9u);
+		Hash ^= Hash >> 16;
+		Hash *= 0x85ebca6bu;
+		Hash ^= Hash >> 13;
+		Hash *= 0xc2b2ae35u;
+		Hash ^= Hash >> 16;
+		return Hash;
+	}
+
+	uint32 SobolBits(uint32 Index, int32 Dimension)
+	{
+		const uint32* Directions = GetSobolTables().Directions[Dimension];
+		uint32 Bits = 0;
+		for (int32 Bit = 0; Index != 0; ++Bit, Index >>= 1)
+		{
+			if (Index & 1)
+			{
+				Bits ^= Directions[Bit];
+			}
+		}
+		return Bits;
+	}
+
+	// Owen scrambling of a base 2 fraction with its bits in reverse order, from
+	// Laine and Karras, "Stratified Sampling for Stochastic Transparency". Each
+	// bit of the hash only depends on the bits below it, so each bit of the
+	// fraction is flipped depending on the seed and all more significant bits.
+	uint32 ScrambleReversedBits(uint32 Bits, uint32 Seed)
+	{
+		Bits += Seed;
+		Bits ^= Bits * 0x6c50b47cu;
+		Bits ^= Bits * 0xb82f1e52u;
+		Bits ^= Bits * 0xc7afe638u;
+		Bits ^= Bits * 0x8d22f6e6u;
+		return Bits;
+	}
+
+	uint32 OwenScrambleBase2(uint32 Bits, uint32 Seed)
+	{
+		return SeuratReverseBits(ScrambleReversedBits(SeuratReverseBits(Bits), Seed));
+	}
+
+	// Owen scrambling of the radical inverse of |Index| in an odd base. Each
+	// digit is shifted by an amount hashed from the seed and all more
+	// significant digits, so every node of the digit tree is permuted
+	// independently. Digits beyond the precision of a float are left out.
+	double ScrambledRadicalInverse(uint32 Index, uint32 Base, uint32 Seed)
+	{
+		const double InvBase = 1.0 / Base;
+		double Result = 0.0;
+		double Scale = InvBase;
+		uint32 Node = Seed;
+		while (Scale > 1.0 / (1 << 24))
+		{
+			const uint32 Digit = Index % Base;
+			Index /= Base;
+			Result += (Digit + HashSeed(Node, Base)) % Base * Scale;
+			Scale *= InvBase;
+			Node = HashSeed(Node ^ Digit, Seed);
+		}
+		return Result;
+	}
+
+	float FixedToFloat(uint32 Bits)
+	{
+		// The top 24 bits are exact in a float, and keep the result below 1.
+		return (Bits >> 8) * (1.0f / (1 << 24));
+	}
+
+	uint32 FractionToFixed(double Fraction)
+	{
+		return static_cast<uint32>(FMath::Min(Fraction * 4294967296.0, 4294967295.0));
+	}
+}
+
+uint32 SeuratReverseBits(uint32 Bits)
+{
+	Bits = (Bits << 16) | (Bits >> 16);
+	Bits = ((Bits & 0x00ff00ffu) << 8) | ((Bits & 0xff00ff00u) >> 8);
+	Bits = ((Bits & 0x0f0f0f0fu) << 4) | ((Bits & 0xf0f0f0f0u) >> 4);
+	Bits = ((Bits & 0x33333333u) << 2) | ((Bits & 0xccccccccu) >> 2);
+	Bits = ((Bits & 0x55555555u) << 1) | ((Bits & 0xaaaaaaaau) >> 1);
+	return Bits;
+}
+
+float RadicalInverseBase2(uint32 Index)
+{
+	return FixedToFloat(SeuratReverseBits(Index));
+}
+
+FSeuratLowDiscrepancySequence::FSeuratLowDiscrepancySequence(ESeuratSequence InSequence, int32 InNumDimensions, bool bInScramble, uint32 InSeed)
+	: Sequence(InSequence)
+	, NumDimensions(FMath::Clamp(InNumDimensions, 1, kMaxDimensions))
+	, bScramble(bInScramble)
+{
+	check(InNumDimensions >= 1 && InNumDimensions <= kMaxDimensions);
+	for (int32 Dimension = 0; Dimension < kMaxDimensions; ++Dimension)
+	{
+		DimensionSeeds[Dimension] = HashSeed(Dimension, InSeed);
+	}
+}
+
+uint32 FSeuratLowDiscrepancySequence::GetSampleBits(uint32 Index, int32 Dimension) const
+{
+	check(Dimension >= 0 && Dimension < NumDimensions);
+	if (Sequence == ESeuratSequence::Sobol)
+	{
+		const uint32 Bits = SobolBits(Index, Dimension);
+		return bScramble ? OwenScrambleBase2(Bits, DimensionSeeds[Dimension]) : Bits;
+	}
+
+	if (Dimension == 0)
+	{
+		// The radical inverse base 2 is the bit reversal of the index, so the
+		// reversal before scrambling cancels out.
+		return SeuratReverseBits(bScramble ? ScrambleReversedBits(Index, DimensionSeeds[0]) : Index);
+	}
+	if (bScramble)
+	{
+		return FractionToFixed(ScrambledRadicalInverse(Index, kHaltonBases[Dimension], DimensionSeeds[Dimension]));
+	}
+	return FractionToFixed(GetRadicalInverseTables().Tables[Dimension].Evaluate(Index));
+}
+
+float FSeuratLowDiscrepancySequence::GetSample(uint32 Index, int32 Dimension) const
+{
+	return FixedToFloat(GetSampleBits(Index, Dimension));
+}
+
+void FSeuratLowDiscrepancySequence::Generate(uint32 FirstIndex, int32 NumPoints, TArray<TArray<float>>& OutDimensions) const
+{
+	NumPoints = FMath::Max(NumPoints, 0);
+	OutDimensions.SetNum(NumDimensions);
+	for (int32 Dimension = 0; Dimension < NumDimensions; ++Dimension)
+	{
+		TArray<float>& Samples = OutDimensions[Dimension];
+		Samples.SetNumUninitialized(NumPoints);
+		if (NumPoints == 0)
+		{
+			continue;
+		}
+
+		if (Sequence == ESeuratSequence::Sobol)
+		{
+			// Each point follows from the previous one with a single XOR.
+			const uint32* Steps = GetSobolTables().Steps[Dimension];
+			const uint32 Seed = DimensionSeeds[Dimension];
+			uint32 Bits = SobolBits(FirstIndex, Dimension);
+			for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+			{
+				if (PointIndex > 0)
+				{
+					Bits ^= Steps[FMath::CountTrailingZeros(FirstIndex + PointIndex)];
+				}
+				Samples[PointIndex] = FixedToFloat(bScramble ? OwenScrambleBase2(Bits, Seed) : Bits);
+			}
+		}
+		else if (Dimension == 0 || bScramble)
+		{
+			for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+			{
+				Samples[PointIndex] = FixedToFloat(GetSampleBits(FirstIndex + PointIndex, Dimension));
+			}
+		}
+		else
+		{
+			// Within a chunk of the table only the lowest digits change, so the
+			// radical inverse of the higher digits is computed once per chunk.
+			const FRadicalInverseTable& Table = GetRadicalInverseTables().Tables[Dimension];
+			uint32 Index = FirstIndex;
+			int32 PointIndex = 0;
+			while (PointIndex < NumPoints)
+			{
+				const double High = Table.Evaluate(Index / Table.ChunkSize) * Table.InvChunkSize;
+				for (uint32 Digits = Index % Table.ChunkSize; Digits < Table.ChunkSize && PointIndex < NumPoints; ++Digits, ++Index, ++PointIndex)
+				{
+					Samples[PointIndex] = FixedToFloat(FractionToFixed(Table.Inverses[Digits] + High));
+				}
+			}
+		}
+	}
+}
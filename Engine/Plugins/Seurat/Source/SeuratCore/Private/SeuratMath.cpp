@@ -0,0 +1,90 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratMath.h"
+
+FMatrix SeuratMatrixFromUnrealMatrix(FMatrix UnrealTransform) {
+	// Use a change of basis to transform the matrix from Unreal's coordinate
+	// system into Seurat's. The matrix SeuratFromUnrealCoordinates encodes
+	// the following change of coordinates:
+	//
+	// Unreal +X is forward and maps to Seurat -Z.
+	// Unreal +Y is right and maps to Seurat +X.
+	// Unreal +Z is up and maps to Seurat +Y.
+	const FMatrix SeuratFromUnrealCoordinates(
+		FPlane(0, 1, 0, 0),
+		FPlane(0, 0, 1, 0),
+		FPlane(-1, 0, 0, 0),
+		FPlane(0, 0, 0, 1));
+
+	// Apply the change of basis, S = P * U * P^-1, to convert Unreal matrix U to
+	// Seurat matrix S. Note that some authors define the change of basis with
+	// the form S = P^-1 * U * P, and in this case P would be the transformation
+	// from Seurat to Unreal coordinates.
+	return SeuratFromUnrealCoordinates * UnrealTransform * SeuratFromUnrealCoordinates.Inverse();
+}
+
+FMatrix SeuratClipFromEyeMatrix(float NearClipPlane)
+{
+	// Note, this matrix won't necessarily match Unreal's projection matrix. It
+	// doesn't matter in this case, because the Unreal plug captures eye space Z,
+	// so it doesn't need to decode from window space. However, the matrix informs
+	// Seurat of the near clip plane, and that the far clip is infinite. This also
+	// allows Seurat to do some window space operations on the captured points.
+	// This matrix is for a 90 degree frustum, infinite Z.
+	float C = -1.0f;
+	float D = -2 * NearClipPlane;
+	return FMatrix(
+		FPlane{ 1, 0, 0, 0 },
+		FPlane{ 0, 1, 0, 0 },
+		FPlane{ 0, 0, C, C },
+		FPlane{ 0, 0, D, 0 });
+}
+
+// Cube captures render each face with the D3D cubemap basis rather than the
+// rotations used for separate face captures, so e.g. the side faces are rolled;
+// deriving the manifest matrices from the same basis keeps the views consistent.
+// Faces are in ECubeFace order: +X, -X, +Y, -Y, +Z, -Z.
+FMatrix CubeFaceWorldFromEye(int32 Face, FVector Position)
+{
+	FVector Up(0.0f, 1.0f, 0.0f);
+	FVector Forward;
+	switch (Face)
+	{
+	case 0:
+		Forward = FVector(1.0f, 0.0f, 0.0f);
+		break;
+	case 1:
+		Forward = FVector(-1.0f, 0.0f, 0.0f);
+		break;
+	case 2:
+		Up = FVector(0.0f, 0.0f, -1.0f);
+		Forward = FVector(0.0f, 1.0f, 0.0f);
+		break;
+	case 3:
+		Up = FVector(0.0f, 0.0f, 1.0f);
+		Forward = FVector(0.0f, -1.0f, 0.0f);
+		break;
+	case 4:
+		Forward = FVector(0.0f, 0.0f, 1.0f);
+		break;
+	case 5:
+	default:
+		Forward = FVector(0.0f, 0.0f, -1.0f);
+		break;
+	}
+	const FVector Right = Up ^ Forward;
+	return FMatrix(Forward, Right, Up, Position);
+}
@@ -0,0 +1,389 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratPack.h"
+#include "SeuratCore.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/ScopeLock.h"
+
+static const uint8 kPackMagic[4] = { 'S', 'P', 'A', 'K' };
+static const uint8 kRecordMagic[4] = { 'S', 'P', 'R', 'C' };
+static const uint8 kIndexMagic[4] = { 'S', 'P', 'I', 'X' };
+static const uint32 kPackVersion = 1;
+static const int64 kRecordAlignment = 16;
+// Longer names are taken as a sign of a corrupt record.
+static const uint32 kMaxNameLength = 1024;
+
+struct FPackHeader
+{
+	uint8 Magic[4];
+	uint32 Version;
+	uint32 SettingsHash;
+	uint32 ResumeBlock;
+	uint64 IndexOffset;
+	uint64 IndexSize;
+};
+
+struct FPackRecordHeader
+{
+	uint8 Magic[4];
+	uint32 NameLength;
+	uint64 PayloadOffset;
+	uint64 PayloadSize;
+};
+
+struct FPackIndexEntry
+{
+	uint64 PayloadOffset;
+	uint64 PayloadSize;
+	uint32 NameOffset;
+	uint32 NameLength;
+};
+
+static_assert(sizeof(FPackHeader) == 32 && sizeof(FPackRecordHeader) == 24 && sizeof(FPackIndexEntry) == 24, "Pack structures must match the file layout.");
+
+// Reads |Size| bytes at |Offset| of the pack.
+typedef TFunctionRef<bool(int64 Offset, void* OutData, int64 Size)> FPackReadFunction;
+
+static FString ReadName(FPackReadFunction ReadAt, int64 Offset, uint32 Length, bool& bOutSucceeded)
+{
+	TArray<ANSICHAR> Name;
+	Name.SetNumZeroed(Length + 1);
+	bOutSucceeded = ReadAt(Offset, Name.GetData(), Length);
+	return UTF8_TO_TCHAR(Name.GetData());
+}
+
+// Whether [Offset, Offset + Size) lies within the first |Limit| bytes. The
+// offset and size come from the file, so their sum may overflow.
+static bool IsRangeWithin(uint64 Offset, uint64 Size, uint64 Limit)
+{
+	return Size <= Limit && Offset <= Limit - Size;
+}
+
+static bool ReadIndex(FPackReadFunction ReadAt, int64 FileSize, const FPackHeader& Header, TMap<FString, FSeuratPackEntry>& OutEntries)
+{
+	uint8 Magic[4];
+	uint32 NumEntries = 0;
+	if (Header.IndexSize < 8 || !IsRangeWithin(Header.IndexOffset, Header.IndexSize, static_cast<uint64>(FileSize))
+		|| !ReadAt(Header.IndexOffset, Magic, sizeof(Magic)) || FMemory::Memcmp(Magic, kIndexMagic, sizeof(Magic)) != 0
+		|| !ReadAt(Header.IndexOffset + 4, &NumEntries, sizeof(NumEntries)) || 8 + static_cast<uint64>(NumEntries) * sizeof(FPackIndexEntry) > Header.IndexSize)
+	{
+		return false;
+	}
+
+	TArray<FPackIndexEntry> IndexEntries;
+	IndexEntries.SetNumUninitialized(NumEntries);
+	const int64 NamesOffset = Header.IndexOffset + 8 + NumEntries * sizeof(FPackIndexEntry);
+	const int64 NamesSize = Header.IndexOffset + Header.IndexSize - NamesOffset;
+	if (!ReadAt(Header.IndexOffset + 8, IndexEntries.GetData(), NumEntries * sizeof(FPackIndexEntry)))
+	{
+		return false;
+	}
+	for (const FPackIndexEntry& IndexEntry : IndexEntries)
+	{
+		if (IndexEntry.NameLength > kMaxNameLength || static_cast<int64>(IndexEntry.NameOffset) + IndexEntry.NameLength > NamesSize
+			|| !IsRangeWithin(IndexEntry.PayloadOffset, IndexEntry.PayloadSize, Header.IndexOffset))
+		{
+			return false;
+		}
+		bool bNameRead = false;
+		const FString Name = ReadName(ReadAt, NamesOffset + IndexEntry.NameOffset, IndexEntry.NameLength, bNameRead);
+		if (!bNameRead)
+		{
+			return false;
+		}
+		OutEntries.Add(Name, FSeuratPackEntry(IndexEntry.PayloadOffset, IndexEntry.PayloadSize));
+	}
+	return true;
+}
+
+// Reads the entries of a pack from its index or, if it has none, by scanning
+// its records. |OutHeader| receives the header of the pack and |OutEnd| the
+// end of the last complete record.
+static bool ReadPack(FPackReadFunction ReadAt, int64 FileSize, FPackHeader& OutHeader, TMap<FString, FSeuratPackEntry>& OutEntries, int64& OutEnd)
+{
+	OutEntries.Empty();
+	if (FileSize < static_cast<int64>(sizeof(OutHeader)) || !ReadAt(0, &OutHeader, sizeof(OutHeader))
+		|| FMemory::Memcmp(OutHeader.Magic, kPackMagic, sizeof(OutHeader.Magic)) != 0 || OutHeader.Version != kPackVersion)
+	{
+		return false;
+	}
+
+	if (OutHeader.IndexOffset != 0 && ReadIndex(ReadAt, FileSize, OutHeader, OutEntries))
+	{
+		OutEnd = OutHeader.IndexOffset;
+		return true;
+	}
+
+	OutEntries.Empty();
+	int64 Position = sizeof(OutHeader);
+	FPackRecordHeader Record;
+	while (Position + static_cast<int64>(sizeof(Record)) <= FileSize && ReadAt(Position, &Record, sizeof(Record)))
+	{
+		const int64 NameOffset = Position + sizeof(Record);
+		if (FMemory::Memcmp(Record.Magic, kRecordMagic, sizeof(Record.Magic)) != 0 || Record.NameLength > kMaxNameLength
+			|| Record.PayloadOffset < static_cast<uint64>(NameOffset + Record.NameLength) || Record.PayloadOffset % kSeuratPackPayloadAlignment != 0
+			|| !IsRangeWithin(Record.PayloadOffset, Record.PayloadSize, static_cast<uint64>(FileSize)))
+		{
+			break;
+		}
+		bool bNameRead = false;
+		const FString Name = ReadName(ReadAt, NameOffset, Record.NameLength, bNameRead);
+		if (!bNameRead)
+		{
+			break;
+		}
+		OutEntries.Add(Name, FSeuratPackEntry(Record.PayloadOffset, Record.PayloadSize));
+		Position = Align(Record.PayloadOffset + Record.PayloadSize, kRecordAlignment);
+	}
+	OutEnd = Position;
+	return true;
+}
+
+static bool ReadFromHandle(IFileHandle& Handle, int64 Offset, void* OutData, int64 Size)
+{
+	return Handle.Seek(Offset) && Handle.Read(static_cast<uint8*>(OutData), Size);
+}
+
+FSeuratPackWriter::FSeuratPackWriter() : SettingsHash(0), ResumeBlock(0), End(0)
+{
+}
+
+FSeuratPackWriter::~FSeuratPackWriter()
+{
+	Close();
+}
+
+bool FSeuratPackWriter::Open(const FString& InFilename, uint32 InSettingsHash, bool bUpdate)
+{
+	Close();
+	Filename = InFilename;
+	SettingsHash = InSettingsHash;
+	Entries.Empty();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	bool bContinue = false;
+	FPackHeader Header;
+	FMemory::Memzero(Header);
+	{
+		TUniquePtr<IFileHandle> ReadHandle(PlatformFile.OpenRead(*Filename));
+		if (ReadHandle.IsValid())
+		{
+			IFileHandle& File = *ReadHandle;
+			bContinue = ReadPack([&File](int64 Offset, void* OutData, int64 Size) { return ReadFromHandle(File, Offset, OutData, Size); },
+				File.Size(), Header, Entries, End) && Header.SettingsHash == SettingsHash && (bUpdate || Header.ResumeBlock != 0);
+		}
+	}
+
+	if (bContinue)
+	{
+		// New records overwrite the index, which is written again on close.
+		Handle.Reset(PlatformFile.OpenWrite(*Filename, true, true));
+	}
+	else
+	{
+		Entries.Empty();
+		End = sizeof(FPackHeader);
+		Handle.Reset(PlatformFile.OpenWrite(*Filename));
+	}
+	// Resuming an interrupted capture keeps the files it wrote resumable. Files
+	// of a completed capture are not; new files start at the next block.
+	ResumeBlock = bContinue && Header.ResumeBlock != 0 ? Header.ResumeBlock : static_cast<uint32>(Align(End, kSeuratPackPayloadAlignment) / kSeuratPackPayloadAlignment);
+	if (!Handle.IsValid() || !WriteHeader(ResumeBlock, 0, 0))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot write pack %s."), *Filename);
+		Handle.Reset();
+		return false;
+	}
+	if (bContinue)
+	{
+		UE_LOG(SeuratCore, Log, TEXT("Continuing pack %s with %d files."), *Filename, Entries.Num());
+	}
+	return true;
+}
+
+bool FSeuratPackWriter::WriteHeader(uint32 HeaderResumeBlock, uint64 IndexOffset, uint64 IndexSize)
+{
+	FPackHeader Header;
+	FMemory::Memzero(Header);
+	FMemory::Memcpy(Header.Magic, kPackMagic, sizeof(Header.Magic));
+	Header.Version = kPackVersion;
+	Header.SettingsHash = SettingsHash;
+	Header.ResumeBlock = HeaderResumeBlock;
+	Header.IndexOffset = IndexOffset;
+	Header.IndexSize = IndexSize;
+	return Handle->Seek(0) && Handle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+}
+
+bool FSeuratPackWriter::Append(const FString& Name, const uint8* Data, int64 Size, FSeuratPackEntry& OutEntry)
+{
+	FTCHARToUTF8 Utf8Name(*Name);
+	check(static_cast<uint32>(Utf8Name.Length()) <= kMaxNameLength);
+
+	FPackRecordHeader Record;
+	FMemory::Memcpy(Record.Magic, kRecordMagic, sizeof(Record.Magic));
+	Record.NameLength = Utf8Name.Length();
+
+	// Files are written one at a time. Encoding, the expensive part, still
+	// runs in parallel.
+	FScopeLock ScopeLock(&Lock);
+	if (!Handle.IsValid())
+	{
+		return false;
+	}
+	Record.PayloadOffset = Align(End + sizeof(Record) + Record.NameLength, kSeuratPackPayloadAlignment);
+	Record.PayloadSize = Size;
+
+	TArray<uint8> RecordData;
+	RecordData.SetNumZeroed(Record.PayloadOffset - End);
+	FMemory::Memcpy(RecordData.GetData(), &Record, sizeof(Record));
+	FMemory::Memcpy(RecordData.GetData() + sizeof(Record), Utf8Name.Get(), Record.NameLength);
+	// A failed write leaves End unchanged, so the next record overwrites the
+	// partial one.
+	if (!Handle->Seek(End) || !Handle->Write(RecordData.GetData(), RecordData.Num()) || !Handle->Write(Data, Size))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot append %s to pack %s."), *Name, *Filename);
+		return false;
+	}
+	End = Align(Record.PayloadOffset + Size, kRecordAlignment);
+	OutEntry = FSeuratPackEntry(Record.PayloadOffset, Size);
+	Entries.Add(Name, OutEntry);
+	return true;
+}
+
+bool FSeuratPackWriter::FindEntry(const FString& Name, FSeuratPackEntry& OutEntry) const
+{
+	FScopeLock ScopeLock(&Lock);
+	const FSeuratPackEntry* Entry = Entries.Find(Name);
+	if (Entry == nullptr)
+	{
+		return false;
+	}
+	OutEntry = *Entry;
+	return true;
+}
+
+bool FSeuratPackWriter::IsResumable(const FString& Name) const
+{
+	FScopeLock ScopeLock(&Lock);
+	const FSeuratPackEntry* Entry = Entries.Find(Name);
+	return Entry != nullptr && Entry->Offset >= static_cast<int64>(ResumeBlock) * kSeuratPackPayloadAlignment;
+}
+
+bool FSeuratPackWriter::Close(bool bCaptureComplete)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (!Handle.IsValid())
+	{
+		return false;
+	}
+
+	TArray<uint8> Index;
+	TArray<ANSICHAR> Names;
+	Index.Append(kIndexMagic, sizeof(kIndexMagic));
+	const uint32 NumEntries = Entries.Num();
+	Index.Append(reinterpret_cast<const uint8*>(&NumEntries), sizeof(NumEntries));
+	for (const TPair<FString, FSeuratPackEntry>& Entry : Entries)
+	{
+		FTCHARToUTF8 Utf8Name(*Entry.Key);
+		FPackIndexEntry IndexEntry;
+		IndexEntry.PayloadOffset = Entry.Value.Offset;
+		IndexEntry.PayloadSize = Entry.Value.Size;
+		IndexEntry.NameOffset = Names.Num();
+		IndexEntry.NameLength = Utf8Name.Length();
+		Names.Append(Utf8Name.Get(), Utf8Name.Length());
+		Index.Append(reinterpret_cast<const uint8*>(&IndexEntry), sizeof(IndexEntry));
+	}
+	Index.Append(reinterpret_cast<const uint8*>(Names.GetData()), Names.Num());
+
+	// The header only points at the index once the index is complete.
+	const bool bSucceeded = Handle->Seek(End) && Handle->Write(Index.GetData(), Index.Num()) && WriteHeader(bCaptureComplete ? 0 : ResumeBlock, End, Index.Num());
+	if (!bSucceeded)
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot write the index of pack %s."), *Filename);
+	}
+	Handle.Reset();
+	return bSucceeded;
+}
+
+FSeuratPackReader::FSeuratPackReader() : Data(nullptr), SettingsHash(0)
+{
+}
+
+FSeuratPackReader::~FSeuratPackReader()
+{
+}
+
+bool FSeuratPackReader::Open(const FString& Filename)
+{
+	Data = nullptr;
+	Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (!Handle.IsValid())
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot read pack %s."), *Filename);
+		return false;
+	}
+	IFileHandle& File = *Handle;
+	FPackHeader Header;
+	int64 End = 0;
+	if (!ReadPack([&File](int64 Offset, void* OutData, int64 Size) { return ReadFromHandle(File, Offset, OutData, Size); }, File.Size(), Header, Entries, End))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("%s is not a valid pack."), *Filename);
+		Handle.Reset();
+		return false;
+	}
+	SettingsHash = Header.SettingsHash;
+	return true;
+}
+
+bool FSeuratPackReader::Initialize(const uint8* InData, int64 InDataSize)
+{
+	Handle.Reset();
+	Data = InData;
+	FPackHeader Header;
+	int64 End = 0;
+	if (!ReadPack([InData, InDataSize](int64 Offset, void* OutData, int64 Size)
+	{
+		if (Offset < 0 || Size < 0 || Offset + Size > InDataSize)
+		{
+			return false;
+		}
+		FMemory::Memcpy(OutData, InData + Offset, Size);
+		return true;
+	}, InDataSize, Header, Entries, End))
+	{
+		return false;
+	}
+	SettingsHash = Header.SettingsHash;
+	return true;
+}
+
+bool FSeuratPackReader::Read(const FSeuratPackEntry& Entry, TArray<uint8>& OutData) const
+{
+	OutData.SetNumUninitialized(Entry.Size);
+	if (Data != nullptr)
+	{
+		FMemory::Memcpy(OutData.GetData(), Data + Entry.Offset, Entry.Size);
+		return true;
+	}
+	return Handle.IsValid() && ReadFromHandle(*Handle, Entry.Offset, OutData.GetData(), Entry.Size);
+}
+
+const uint8* FSeuratPackReader::GetPayload(const FSeuratPackEntry& Entry) const
+{
+	check(Data != nullptr);
+	return Data + Entry.Offset;
+}
@@ -0,0 +1,118 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratPixelBufferPool.h"
+#include "Misc/ScopeLock.h"
+
+FSeuratPixelBufferPool::FSeuratPixelBufferPool() : NumPixels(0)
+{
+}
+
+void FSeuratPixelBufferPool::Configure(int32 InNumPixels)
+{
+	TArray<TArray<FFloat16Color>> Discarded;
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (InNumPixels == NumPixels)
+		{
+			return;
+		}
+		NumPixels = InNumPixels;
+		Stats.NumAllocated -= FreeBuffers.Num();
+		Discarded = MoveTemp(FreeBuffers);
+	}
+	// Discarded is freed here, outside of the lock.
+}
+
+int32 FSeuratPixelBufferPool::GetNumPixels() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return NumPixels;
+}
+
+TArray<FFloat16Color> FSeuratPixelBufferPool::Acquire()
+{
+	TArray<FFloat16Color> Buffer;
+	int32 BufferNumPixels = 0;
+	{
+		FScopeLock ScopeLock(&Lock);
+		BufferNumPixels = NumPixels;
+		++Stats.NumAcquires;
+		++Stats.NumInUse;
+		Stats.PeakInUse = FMath::Max(Stats.PeakInUse, Stats.NumInUse);
+		Stats.PeakBytesInUse = FMath::Max(Stats.PeakBytesInUse, static_cast<int64>(Stats.NumInUse) * NumPixels * sizeof(FFloat16Color));
+		if (FreeBuffers.Num() > 0)
+		{
+			Buffer = FreeBuffers.Pop(false);
+			return Buffer;
+		}
+		++Stats.NumAllocated;
+		++Stats.NumAllocations;
+	}
+
+	// Allocate outside of the lock; the exact size keeps the allocation
+	// reusable by readbacks that size their output to the image.
+	Buffer.Empty(BufferNumPixels);
+	Buffer.AddUninitialized(BufferNumPixels);
+	return Buffer;
+}
+
+TArray<FFloat16Color> FSeuratPixelBufferPool::Acquire(int32 InNumPixels)
+{
+	Configure(InNumPixels);
+	return Acquire();
+}
+
+void FSeuratPixelBufferPool::Release(TArray<FFloat16Color>&& Buffer)
+{
+	TArray<FFloat16Color> Discarded;
+	{
+		FScopeLock ScopeLock(&Lock);
+		--Stats.NumInUse;
+		if (Buffer.Max() == NumPixels)
+		{
+			FreeBuffers.Add(MoveTemp(Buffer));
+			return;
+		}
+		--Stats.NumAllocated;
+		Discarded = MoveTemp(Buffer);
+	}
+	// Discarded is freed here, outside of the lock.
+}
+
+void FSeuratPixelBufferPool::Trim()
+{
+	TArray<TArray<FFloat16Color>> Discarded;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Stats.NumAllocated -= FreeBuffers.Num();
+		Discarded = MoveTemp(FreeBuffers);
+	}
+}
+
+FSeuratPixelBufferPoolStats FSeuratPixelBufferPool::GetStats() const
+{
+	FScopeLock ScopeLock(&Lock);
+	return Stats;
+}
+
+void FSeuratPixelBufferPool::ResetStats()
+{
+	FScopeLock ScopeLock(&Lock);
+	Stats.PeakInUse = Stats.NumInUse;
+	Stats.PeakBytesInUse = static_cast<int64>(Stats.NumInUse) * NumPixels * sizeof(FFloat16Color);
+	Stats.NumAcquires = 0;
+	Stats.NumAllocations = 0;
+}
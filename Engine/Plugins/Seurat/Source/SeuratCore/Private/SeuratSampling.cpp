@@ -0,0 +1,284 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratSampling.h"
+#include "SeuratLowDiscrepancy.h"
+
+float RadicalInverse(uint64 A, uint64 DigitBase) {
+	if (DigitBase == 2 && A <= MAX_uint32) {
+		// Rounds like the loop below: the reversed bits are rounded to a float,
+		// then scaled by a power of two, which is exact.
+		return FMath::Min(static_cast<float>(SeuratReverseBits(static_cast<uint32>(A))) * (1.0f / 4294967296.0f), 1.0f);
+	}
+	float InvBase = 1.0f / DigitBase;
+	uint64 ReversedDigits = 0;
+	float InvBaseN = 1.0f;
+	// Compute the reversed digits in the base entirely in integer arithmetic.
+	while (A != 0) {
+		uint64 Next = A / DigitBase;
+		uint64 Digit = A - Next * DigitBase;
+		ReversedDigits = ReversedDigits * DigitBase + Digit;
+		InvBaseN *= InvBase;
+		A = Next;
+	}
+	// Only when done are the reversed digits divided by base^n.
+	return FMath::Min(ReversedDigits * InvBaseN, 1.0f);
+}
+
+// Squared distance of |Sample| from the headbox center relative to the
+// distance of the faces, along each headbox axis.
+static float GetRelativeDistanceSquared(const FVector& Sample, const FVector& HeadboxSize, const FTransform& HeadboxToWorld)
+{
+	const FVector HeadboxPosition = HeadboxToWorld.InverseTransformPosition(Sample);
+	const FVector HalfSize = (HeadboxSize * 0.5f).ComponentMax(FVector(KINDA_SMALL_NUMBER));
+	return (HeadboxPosition / HalfSize).SizeSquared();
+}
+
+bool IsHeadboxCube(const FVector& HeadboxSize, const FTransform& HeadboxToWorld)
+{
+	const FVector WorldSize = HeadboxSize * HeadboxToWorld.GetScale3D().GetAbs();
+	return WorldSize.X == WorldSize.Y && WorldSize.Y == WorldSize.Z;
+}
+
+// Places samples given as headbox coordinates in [0, 1) in world space, sorted
+// by distance from the headbox center, with the first sample at the center.
+static void PlaceHeadboxSamples(const TArray<TArray<float>>& Coordinates, const FVector& HeadboxSize, const FTransform& HeadboxToWorld, TArray<FVector>& OutSamples)
+{
+	const int32 NumSamples = Coordinates[0].Num();
+	const FVector CameraLocation = HeadboxToWorld.GetLocation();
+
+	// Each sample's distance from the headbox center is computed once, rather
+	// than in every comparison of the sort. Squared distances order the same.
+	struct FSampleDistance
+	{
+		float DistanceSquared;
+		int32 Index;
+		bool operator<(const FSampleDistance& Other) const
+		{
+			// Ties break by index, so the order doesn't depend on the sort.
+			return DistanceSquared < Other.DistanceSquared || (DistanceSquared == Other.DistanceSquared && Index < Other.Index);
+		}
+	};
+	TArray<FVector> Positions;
+	Positions.Reserve(NumSamples);
+	TArray<FSampleDistance> Distances;
+	Distances.Reserve(NumSamples);
+
+	for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+	{
+		FVector HeadboxPosition = FVector(Coordinates[0][SampleIndex], Coordinates[1][SampleIndex], Coordinates[2][SampleIndex]);
+		HeadboxPosition.X *= HeadboxSize.X;
+		HeadboxPosition.Y *= HeadboxSize.Y;
+		HeadboxPosition.Z *= HeadboxSize.Z;
+		HeadboxPosition -= HeadboxSize * 0.5f;
+		// Headbox samples are in camera space; transform to world space.
+		HeadboxPosition = HeadboxToWorld.TransformPosition(HeadboxPosition);
+		Positions.Add(HeadboxPosition);
+		Distances.Add({ (HeadboxPosition - CameraLocation).SizeSquared(), SampleIndex });
+	}
+
+	// Sort samples by distance from center of the headbox.
+	OutSamples.Empty(NumSamples);
+	Distances.Sort();
+	for (const FSampleDistance& Distance : Distances)
+	{
+		OutSamples.Add(Positions[Distance.Index]);
+	}
+
+	// Replace the sample closest to the center of the headbox with a sample at
+	// exactly the center. This is important because Seurat requires
+	// sampling information at the center of the headbox.
+	OutSamples[0] = CameraLocation;
+}
+
+void GenerateHeadboxSamples(int32 NumSamples, const FVector& HeadboxSize, const FTransform& HeadboxToWorld, TArray<FVector>& OutSamples,
+	ESeuratSamplePattern Pattern, uint32 Seed)
+{
+	OutSamples.Empty(NumSamples);
+	if (NumSamples <= 0)
+	{
+		return;
+	}
+
+	// Use low discrepancy sampling for reproduciblity. Hammersley points are
+	// the sample index and the radical inverses in bases 2 and 3. They are
+	// computed with RadicalInverse, whose float rounding the settings hash and
+	// existing captures rely on; the double precision Halton tables round
+	// differently.
+	TArray<TArray<float>> Coordinates;
+	if (Pattern == ESeuratSamplePattern::Hammersley)
+	{
+		Coordinates.SetNum(3);
+		for (TArray<float>& Coordinate : Coordinates)
+		{
+			Coordinate.SetNumUninitialized(NumSamples);
+		}
+		for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+		{
+			Coordinates[0][SampleIndex] = NumSamples > 1 ? (float)SampleIndex / (float)(NumSamples - 1) : 0.5f;
+			Coordinates[1][SampleIndex] = RadicalInverse((uint64)SampleIndex, 2);
+			Coordinates[2][SampleIndex] = RadicalInverse((uint64)SampleIndex, 3);
+		}
+	}
+	else
+	{
+		FSeuratLowDiscrepancySequence(ESeuratSequence::Sobol, 3, Pattern == ESeuratSamplePattern::ScrambledSobol, Seed).Generate(0, NumSamples, Coordinates);
+	}
+	PlaceHeadboxSamples(Coordinates, HeadboxSize, HeadboxToWorld, OutSamples);
+}
+
+FVector GetHeadboxCorner(int32 Corner, const FVector& HeadboxSize, const FTransform& HeadboxToWorld)
+{
+	const FVector HeadboxPosition(
+		(Corner & 1) ? 0.5f : -0.5f,
+		(Corner & 2) ? 0.5f : -0.5f,
+		(Corner & 4) ? 0.5f : -0.5f);
+	return HeadboxToWorld.TransformPosition(HeadboxPosition * HeadboxSize);
+}
+
+float EstimateDisocclusion(const TArray<float>& Depths, int32 Width, int32 Height, float MinDepth)
+{
+	check(Depths.Num() >= Width * Height);
+	// A depth edge between depths Z0 and Z1 opens a gap of about
+	// |1 / Z0 - 1 / Z1| radians per unit of viewer motion, so the sum of the
+	// inverse depth differences of neighboring pixels measures how much of the
+	// scene a viewer moving away from here would see that was hidden before.
+	const float MaxInverseDepth = 1.0f / FMath::Max(MinDepth, KINDA_SMALL_NUMBER);
+	double Disocclusion = 0.0;
+	for (int32 Y = 0; Y < Height; ++Y)
+	{
+		const float* Row = &Depths[Y * Width];
+		const float* NextRow = Y + 1 < Height ? Row + Width : nullptr;
+		for (int32 X = 0; X < Width; ++X)
+		{
+			const float InverseDepth = FMath::Min(1.0f / FMath::Max(Row[X], KINDA_SMALL_NUMBER), MaxInverseDepth);
+			if (X + 1 < Width)
+			{
+				Disocclusion += FMath::Abs(InverseDepth - FMath::Min(1.0f / FMath::Max(Row[X + 1], KINDA_SMALL_NUMBER), MaxInverseDepth));
+			}
+			if (NextRow != nullptr)
+			{
+				Disocclusion += FMath::Abs(InverseDepth - FMath::Min(1.0f / FMath::Max(NextRow[X], KINDA_SMALL_NUMBER), MaxInverseDepth));
+			}
+		}
+	}
+	// Normalized by the pixel size, so the estimate doesn't depend on the
+	// resolution of the depth images.
+	return static_cast<float>(Disocclusion / FMath::Max(Width, Height));
+}
+
+// Draws t in [0, 1) with a density varying linearly from A at 0 to B at 1,
+// by inverting the cumulative distribution at |U|.
+static float SampleLinearDensity(float U, float A, float B)
+{
+	const float Slope = B - A;
+	if (FMath::Abs(Slope) < KINDA_SMALL_NUMBER * (A + B))
+	{
+		return U;
+	}
+	// Solves A t + Slope t^2 / 2 = U (A + B) / 2 for t.
+	const float Discriminant = FMath::Max(A * A + Slope * U * (A + B), 0.0f);
+	return FMath::Clamp((FMath::Sqrt(Discriminant) - A) / Slope, 0.0f, 1.0f);
+}
+
+void GenerateAdaptiveHeadboxSamples(int32 NumSamples, const FVector& HeadboxSize, const FTransform& HeadboxToWorld, const TArray<float>& CornerWeights, uint32 Seed, TArray<FVector>& OutSamples)
+{
+	OutSamples.Empty(NumSamples);
+	if (NumSamples <= 0)
+	{
+		return;
+	}
+	check(CornerWeights.Num() == kNumHeadboxCorners);
+
+	// Warps scrambled Sobol points to the trilinear density, one axis at a time:
+	// X by the marginal density of X, then Y by the density given X, and Z by
+	// the density given X and Y. Each of these is linear, and the warp keeps
+	// the stratification of the points.
+	TArray<TArray<float>> Coordinates;
+	FSeuratLowDiscrepancySequence(ESeuratSequence::Sobol, 3, true, Seed).Generate(0, NumSamples, Coordinates);
+	for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+	{
+		// Weights of the corners at X = 0 and X = 1, indexed by Y + 2 Z.
+		float X0[4];
+		float X1[4];
+		for (int32 YZ = 0; YZ < 4; ++YZ)
+		{
+			X0[YZ] = FMath::Max(CornerWeights[YZ * 2], 0.0f);
+			X1[YZ] = FMath::Max(CornerWeights[YZ * 2 + 1], 0.0f);
+		}
+		const float X = SampleLinearDensity(Coordinates[0][SampleIndex], X0[0] + X0[1] + X0[2] + X0[3], X1[0] + X1[1] + X1[2] + X1[3]);
+
+		float YZ[4];
+		for (int32 Index = 0; Index < 4; ++Index)
+		{
+			YZ[Index] = FMath::Lerp(X0[Index], X1[Index], X);
+		}
+		const float Y = SampleLinearDensity(Coordinates[1][SampleIndex], YZ[0] + YZ[2], YZ[1] + YZ[3]);
+		const float Z = SampleLinearDensity(Coordinates[2][SampleIndex], FMath::Lerp(YZ[0], YZ[1], Y), FMath::Lerp(YZ[2], YZ[3], Y));
+
+		Coordinates[0][SampleIndex] = X;
+		Coordinates[1][SampleIndex] = Y;
+		Coordinates[2][SampleIndex] = Z;
+	}
+	PlaceHeadboxSamples(Coordinates, HeadboxSize, HeadboxToWorld, OutSamples);
+}
+
+int32 GetSampleResolutionLevel(const FVector& Sample, const FVector& HeadboxSize, const FTransform& HeadboxToWorld, float FalloffStart, int32 MaxLevels)
+{
+	if (MaxLevels <= 0)
+	{
+		return 0;
+	}
+	// Distance from the center relative to the distance of the corners.
+	const float Radius = FMath::Sqrt(GetRelativeDistanceSquared(Sample, HeadboxSize, HeadboxToWorld)) / FMath::Sqrt(3.0f);
+	if (Radius <= FalloffStart)
+	{
+		return 0;
+	}
+	const float Falloff = (Radius - FalloffStart) / FMath::Max(1.0f - FalloffStart, KINDA_SMALL_NUMBER);
+	return FMath::Clamp(FMath::CeilToInt(Falloff * MaxLevels), 0, MaxLevels);
+}
+
+void SortSamplesForResolutionFalloff(TArray<FVector>& Samples, const FVector& HeadboxSize, const FTransform& HeadboxToWorld)
+{
+	struct FSampleDistance
+	{
+		float DistanceSquared;
+		int32 Index;
+		bool operator<(const FSampleDistance& Other) const
+		{
+			return DistanceSquared < Other.DistanceSquared || (DistanceSquared == Other.DistanceSquared && Index < Other.Index);
+		}
+	};
+	// The first sample stays at the center.
+	TArray<FSampleDistance> Distances;
+	Distances.Reserve(Samples.Num());
+	for (int32 SampleIndex = 1; SampleIndex < Samples.Num(); ++SampleIndex)
+	{
+		Distances.Add({ GetRelativeDistanceSquared(Samples[SampleIndex], HeadboxSize, HeadboxToWorld), SampleIndex });
+	}
+	Distances.Sort();
+	TArray<FVector> Sorted;
+	Sorted.Reserve(Samples.Num());
+	if (Samples.Num() > 0)
+	{
+		Sorted.Add(Samples[0]);
+	}
+	for (const FSampleDistance& Distance : Distances)
+	{
+		Sorted.Add(Samples[Distance.Index]);
+	}
+	Samples = MoveTemp(Sorted);
+}
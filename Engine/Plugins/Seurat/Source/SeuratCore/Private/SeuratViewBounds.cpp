@@ -0,0 +1,160 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratViewBounds.h"
+#include "SeuratCore.h"
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+// Largest finite half precision float.
+static const float kMaxHalfFloat = 65504.0f;
+
+FSeuratViewDepthRange MakeSeuratViewDepthRange(float MinDepth, float MaxDepth, float SkyDepth)
+{
+	FSeuratViewDepthRange DepthRange;
+	DepthRange.MinDepth = FMath::IsFinite(MinDepth) ? FMath::Clamp(MinDepth, 0.0f, kMaxHalfFloat) : 0.0f;
+	const bool bBounded = FMath::IsFinite(MaxDepth) && MaxDepth < SkyDepth && MaxDepth < kMaxHalfFloat;
+	DepthRange.MaxDepth = bBounded ? FMath::Max(MaxDepth, 0.0f) : kSeuratUnboundedDepth;
+	return DepthRange;
+}
+
+bool SeuratViewMayShowBox(const FMatrix& WorldFromEye, float NearClipPlane, float MaxDepth, const FBox& Box)
+{
+	// With a 90 degree field of view, the frustum is bounded by the planes
+	// X = |Y| and X = |Z| in eye space, plus the near and depth planes. The box
+	// is hidden if all of its corners are outside one of these planes.
+	const FMatrix EyeFromWorld = WorldFromEye.InverseFast();
+	FVector Corners[8];
+	for (int32 CornerIndex = 0; CornerIndex < 8; ++CornerIndex)
+	{
+		const FVector Corner(
+			(CornerIndex & 1) ? Box.Max.X : Box.Min.X,
+			(CornerIndex & 2) ? Box.Max.Y : Box.Min.Y,
+			(CornerIndex & 4) ? Box.Max.Z : Box.Min.Z);
+		Corners[CornerIndex] = EyeFromWorld.TransformPosition(Corner);
+	}
+
+	// Views without a finite max depth have no depth plane.
+	const bool bBounded = FMath::IsFinite(MaxDepth) && MaxDepth < kSeuratUnboundedDepth;
+	bool bOutside[6] = { true, bBounded, true, true, true, true };
+	for (const FVector& Corner : Corners)
+	{
+		bOutside[0] &= Corner.X < NearClipPlane;
+		bOutside[1] &= Corner.X > MaxDepth;
+		bOutside[2] &= Corner.X < Corner.Y;
+		bOutside[3] &= Corner.X < -Corner.Y;
+		bOutside[4] &= Corner.X < Corner.Z;
+		bOutside[5] &= Corner.X < -Corner.Z;
+	}
+	for (bool bPlaneOutside : bOutside)
+	{
+		if (bPlaneOutside)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+FSeuratViewBoundsFile::FSeuratViewBoundsFile() : SettingsHash(0)
+{
+}
+
+void FSeuratViewBoundsFile::Reset(uint32 InSettingsHash)
+{
+	SettingsHash = InSettingsHash;
+	DepthRanges.Empty();
+}
+
+bool FSeuratViewBoundsFile::Load(const FString& Filename)
+{
+	Reset(0);
+
+	FString Text;
+	if (!FFileHelper::LoadFileToString(Text, *Filename))
+	{
+		return false;
+	}
+	TSharedPtr<FJsonObject> Root;
+	TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(Text);
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+	{
+		UE_LOG(SeuratCore, Warning, TEXT("Cannot parse view bounds %s."), *Filename);
+		return false;
+	}
+
+	SettingsHash = FParse::HexNumber(*Root->GetStringField(TEXT("settings_hash")));
+	const TArray<TSharedPtr<FJsonValue>>* Views = nullptr;
+	if (Root->TryGetArrayField(TEXT("views"), Views))
+	{
+		for (const TSharedPtr<FJsonValue>& ViewValue : *Views)
+		{
+			const TSharedPtr<FJsonObject> View = ViewValue->AsObject();
+			if (View.IsValid())
+			{
+				// Unbounded views are saved without a max depth.
+				double MaxDepth = 0.0;
+				DepthRanges.Add(View->GetStringField(TEXT("path")), FSeuratViewDepthRange(
+					static_cast<float>(View->GetNumberField(TEXT("min_depth"))),
+					View->TryGetNumberField(TEXT("max_depth"), MaxDepth) ? static_cast<float>(MaxDepth) : kSeuratUnboundedDepth));
+			}
+		}
+	}
+	return true;
+}
+
+bool FSeuratViewBoundsFile::Save(const FString& Filename) const
+{
+	FString Text;
+	TSharedRef<TJsonWriter<TCHAR>> Writer = TJsonWriterFactory<TCHAR>::Create(&Text);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("settings_hash"), FString::Printf(TEXT("%08x"), SettingsHash));
+	Writer->WriteArrayStart(TEXT("views"));
+	for (const TPair<FString, FSeuratViewDepthRange>& DepthRange : DepthRanges)
+	{
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("path"), DepthRange.Key);
+		// JSON has no infinity, so only finite depths are written.
+		Writer->WriteValue(TEXT("min_depth"), FMath::IsFinite(DepthRange.Value.MinDepth) ? DepthRange.Value.MinDepth : 0.0f);
+		if (DepthRange.Value.IsBounded() && FMath::IsFinite(DepthRange.Value.MaxDepth))
+		{
+			Writer->WriteValue(TEXT("max_depth"), DepthRange.Value.MaxDepth);
+		}
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	if (!FFileHelper::SaveStringToFile(Text, *Filename))
+	{
+		UE_LOG(SeuratCore, Error, TEXT("Cannot write view bounds %s."), *Filename);
+		return false;
+	}
+	return true;
+}
+
+void FSeuratViewBoundsFile::SetDepthRange(const FString& ImageName, const FSeuratViewDepthRange& DepthRange)
+{
+	DepthRanges.Add(ImageName, DepthRange);
+}
+
+const FSeuratViewDepthRange* FSeuratViewBoundsFile::FindDepthRange(const FString& ImageName) const
+{
+	return DepthRanges.Find(ImageName);
+}
@@ -0,0 +1,114 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratCaptureScheduler.h"
+#include "SeuratCoreTests.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// A fence the test signals by hand.
+class FFakeFence : public ISeuratCaptureFence
+{
+public:
+	FFakeFence() : bComplete(false) {}
+
+	virtual bool IsComplete() const override { return bComplete; }
+
+	bool bComplete;
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSeuratCaptureSchedulerTest, "Seurat.Core.CaptureScheduler", SEURAT_CORE_TEST_FLAGS)
+
+bool FSeuratCaptureSchedulerTest::RunTest(const FString& Parameters)
+{
+	TArray<TSharedRef<FFakeFence>> Fences;
+	TArray<FSeuratCaptureJob> Issued;
+	auto Issue = [&Fences, &Issued](const FSeuratCaptureJob& Job) -> TSharedRef<ISeuratCaptureFence>
+	{
+		Issued.Add(Job);
+		TSharedRef<FFakeFence> Fence = MakeShareable(new FFakeFence());
+		Fences.Add(Fence);
+		return Fence;
+	};
+	auto CanIssue = []() { return true; };
+
+	// Two samples of three sides, at most two jobs per tick and three in flight.
+	FSeuratCaptureScheduler Scheduler;
+	Scheduler.Reset(2, 3, 2, 3);
+	TestEqual(TEXT("Jobs"), Scheduler.GetNumJobs(), 6);
+
+	TestEqual(TEXT("Jobs issued by the first tick"), Scheduler.Tick(CanIssue, Issue), 2);
+	TestEqual(TEXT("Jobs issued by the second tick"), Scheduler.Tick(CanIssue, Issue), 1);
+	TestEqual(TEXT("Jobs issued with the in-flight limit reached"), Scheduler.Tick(CanIssue, Issue), 0);
+	TestEqual(TEXT("Jobs in flight"), Scheduler.GetNumInFlight(), 3);
+
+	// Fences signal in issue order; a later fence that signals early doesn't
+	// retire its job before the earlier ones.
+	Fences[1]->bComplete = true;
+	TestEqual(TEXT("Jobs issued before the first fence signals"), Scheduler.Tick(CanIssue, Issue), 0);
+	TestEqual(TEXT("Jobs retired before the first fence signals"), Scheduler.GetNumRetired(), 0);
+
+	Fences[0]->bComplete = true;
+	TestEqual(TEXT("Jobs issued once two jobs retire"), Scheduler.Tick(CanIssue, Issue), 2);
+	TestEqual(TEXT("Jobs retired once the first fence signals"), Scheduler.GetNumRetired(), 2);
+	TestTrue(TEXT("Jobs in flight stay within the limit"), Scheduler.GetNumInFlight() <= 3);
+
+	// CanIssue holds jobs back, e.g. while the writers catch up.
+	TestEqual(TEXT("Jobs issued while CanIssue is false"), Scheduler.Tick([]() { return false; }, Issue), 0);
+
+	for (int32 TickIndex = 0; TickIndex < 6 && !Scheduler.IsComplete(); ++TickIndex)
+	{
+		for (const TSharedRef<FFakeFence>& Fence : Fences)
+		{
+			Fence->bComplete = true;
+		}
+		Scheduler.Tick(CanIssue, Issue);
+		TestTrue(TEXT("Jobs in flight stay within the limit"), Scheduler.GetNumInFlight() <= 3);
+	}
+	TestTrue(TEXT("Scheduler completes"), Scheduler.IsComplete());
+	TestEqual(TEXT("Jobs issued"), Issued.Num(), 6);
+	for (int32 JobIndex = 0; JobIndex < Issued.Num(); ++JobIndex)
+	{
+		TestEqual(TEXT("Sample of job in issue order"), Issued[JobIndex].SampleIndex, JobIndex / 3);
+		TestEqual(TEXT("Side of job in issue order"), Issued[JobIndex].SideIndex, JobIndex % 3);
+	}
+
+	// Removed jobs are never issued, and the others keep their order.
+	Fences.Empty();
+	Issued.Empty();
+	Scheduler.Reset(2, 3, 6, 6);
+	const int32 NumRemoved = Scheduler.RemoveJobs([](const FSeuratCaptureJob& Job) { return Job.SideIndex == 1; });
+	TestEqual(TEXT("Removed jobs"), NumRemoved, 2);
+	TestEqual(TEXT("Jobs left"), Scheduler.GetNumJobs(), 4);
+	TestEqual(TEXT("Jobs issued after removal"), Scheduler.Tick(CanIssue, Issue), 4);
+	for (const FSeuratCaptureJob& Job : Issued)
+	{
+		TestTrue(TEXT("Removed job is not issued"), Job.SideIndex != 1);
+	}
+	for (const TSharedRef<FFakeFence>& Fence : Fences)
+	{
+		Fence->bComplete = true;
+	}
+	Scheduler.Tick(CanIssue, Issue);
+	TestTrue(TEXT("Scheduler completes after removal"), Scheduler.IsComplete());
+
+	// A scheduler whose jobs are all removed is complete without a tick.
+	Scheduler.Reset(1, 6, 1, 1);
+	Scheduler.RemoveJobs([](const FSeuratCaptureJob&) { return true; });
+	TestTrue(TEXT("Scheduler without jobs is complete"), Scheduler.IsComplete());
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,143 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratDepthCodec.h"
+#include "SeuratCoreTests.h"
+#include "Math/Float16.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	float FloatFromBits(uint32 Bits)
+	{
+		float Value;
+		FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+		return Value;
+	}
+
+	void SetHeaderSize(TArray<uint8>& Data, uint32 Width, uint32 Height)
+	{
+		for (int32 Byte = 0; Byte < 4; ++Byte)
+		{
+			Data[8 + Byte] = static_cast<uint8>(Width >> (Byte * 8));
+			Data[12 + Byte] = static_cast<uint8>(Height >> (Byte * 8));
+		}
+	}
+
+	bool RoundTrips(const TArray<float>& Depths, int32 Width, int32 Height)
+	{
+		TArray<uint8> Data;
+		EncodeSeuratDepth(Depths.GetData(), Width, Height, Data);
+		TArray<float> Decoded;
+		int32 DecodedWidth = -1;
+		int32 DecodedHeight = -1;
+		return DecodeSeuratDepth(Data.GetData(), Data.Num(), Decoded, DecodedWidth, DecodedHeight) &&
+			DecodedWidth == Width && DecodedHeight == Height && Decoded.Num() == Depths.Num() &&
+			FMemory::Memcmp(Decoded.GetData(), Depths.GetData(), Depths.Num() * sizeof(float)) == 0;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSeuratDepthCodecTest, "Seurat.Core.DepthCodec", SEURAT_CORE_TEST_FLAGS)
+
+bool FSeuratDepthCodecTest::RunTest(const FString& Parameters)
+{
+	// Smooth depth with edges, at the half precision of read back depth, and
+	// full precision depth with the special values a capture can contain.
+	FRandomStream Random(0xdeb7);
+	const FIntPoint Sizes[] = { FIntPoint(1, 1), FIntPoint(1, 97), FIntPoint(97, 1), FIntPoint(64, 64), FIntPoint(37, 23) };
+	for (const FIntPoint& Size : Sizes)
+	{
+		TArray<float> Depths;
+		for (int32 Y = 0; Y < Size.Y; ++Y)
+		{
+			for (int32 X = 0; X < Size.X; ++X)
+			{
+				const float Depth = X < Size.X / 2 ? 100.0f + X + 2.0f * Y : 5000.0f - Y;
+				Depths.Add(FFloat16(Depth).GetFloat());
+			}
+		}
+		TestTrue(FString::Printf(TEXT("Half precision %d x %d depth round trips"), Size.X, Size.Y), RoundTrips(Depths, Size.X, Size.Y));
+
+		// Zeros, the smallest denormal, the largest float, a NaN and infinities.
+		const float Specials[] = { 0.0f, FloatFromBits(0x80000000u), FloatFromBits(1), MAX_flt, -1.0f,
+			FloatFromBits(0x7fc00000u), FloatFromBits(0x7f800000u), FloatFromBits(0xff800000u) };
+		for (float& Depth : Depths)
+		{
+			Depth = Random.FRand() < 0.25f ? Specials[Random.RandHelper(ARRAY_COUNT(Specials))] : Random.FRandRange(0.0f, 1.0e5f);
+		}
+		TestTrue(FString::Printf(TEXT("Full precision %d x %d depth round trips"), Size.X, Size.Y), RoundTrips(Depths, Size.X, Size.Y));
+	}
+	TestTrue(TEXT("Empty depth round trips"), RoundTrips(TArray<float>(), 0, 0));
+
+	// Empty images are stored as 0 x 0.
+	TArray<uint8> Data;
+	int32 Width = -1;
+	int32 Height = -1;
+	EncodeSeuratDepth(nullptr, 0, 5, Data);
+	TestTrue(TEXT("Size of an encoded 0 x 5 image"), GetSeuratDepthSize(Data.GetData(), Data.Num(), Width, Height) && Width == 0 && Height == 0);
+
+	// Corrupt headers are rejected, without reading or allocating beyond the
+	// header.
+	TArray<float> Depths;
+	Depths.Init(250.0f, 16 * 16);
+	TArray<uint8> Encoded;
+	EncodeSeuratDepth(Depths.GetData(), 16, 16, Encoded);
+	TArray<float> Decoded;
+	TestTrue(TEXT("Encoded size"), GetSeuratDepthSize(Encoded.GetData(), Encoded.Num(), Width, Height) && Width == 16 && Height == 16);
+
+	Data = Encoded;
+	Data[0] = 'X';
+	TestFalse(TEXT("Decodes with a wrong magic"), DecodeSeuratDepth(Data.GetData(), Data.Num(), Decoded, Width, Height));
+	Data = Encoded;
+	Data[4] = 0xff;
+	TestFalse(TEXT("Decodes with an unknown version"), DecodeSeuratDepth(Data.GetData(), Data.Num(), Decoded, Width, Height));
+	Data = Encoded;
+	Data[5] = 32;
+	TestFalse(TEXT("Decodes with a shift of 32 bits"), DecodeSeuratDepth(Data.GetData(), Data.Num(), Decoded, Width, Height));
+
+	Data = Encoded;
+	SetHeaderSize(Data, 0, 16);
+	TestFalse(TEXT("Decodes with a width of zero and rows"), DecodeSeuratDepth(Data.GetData(), Data.Num(), Decoded, Width, Height));
+	SetHeaderSize(Data, 16, 0);
+	TestFalse(TEXT("Decodes with a height of zero and columns"), DecodeSeuratDepth(Data.GetData(), Data.Num(), Decoded, Width, Height));
+	SetHeaderSize(Data, 0x80000000u, 1);
+	TestFalse(TEXT("Decodes with a width beyond int32"), DecodeSeuratDepth(Data.GetData(), Data.Num(), Decoded, Width, Height));
+	SetHeaderSize(Data, 16, 17);
+	TestFalse(TEXT("Decodes with more rows than encoded"), DecodeSeuratDepth(Data.GetData(), Data.Num(), Decoded, Width, Height));
+
+	// A header whose pixel count overflows int32 is rejected even if the data
+	// could hold that many pixels. Only the header is read.
+	SetHeaderSize(Data, 65536, 65536);
+	const int64 kLargeDataSize = 1ll << 40;
+	TestFalse(TEXT("Size of a header with more pixels than int32 holds"), GetSeuratDepthSize(Data.GetData(), kLargeDataSize, Width, Height));
+	SetHeaderSize(Data, 46341, 46341);
+	TestFalse(TEXT("Size of a header just beyond int32 pixels"), GetSeuratDepthSize(Data.GetData(), kLargeDataSize, Width, Height));
+	SetHeaderSize(Data, 46340, 46340);
+	TestTrue(TEXT("Size of a header just within int32 pixels"), GetSeuratDepthSize(Data.GetData(), kLargeDataSize, Width, Height));
+
+	for (int32 Size = 0; Size < Encoded.Num(); ++Size)
+	{
+		if (DecodeSeuratDepth(Encoded.GetData(), Size, Decoded, Width, Height))
+		{
+			AddError(FString::Printf(TEXT("Decodes depth truncated to %d of %d bytes"), Size, Encoded.Num()));
+			break;
+		}
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
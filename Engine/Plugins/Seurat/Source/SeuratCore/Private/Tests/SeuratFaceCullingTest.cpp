@@ -0,0 +1,96 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratFaceCulling.h"
+#include "SeuratCoreTests.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSeuratFaceCullingTest, "Seurat.Core.FaceCulling", SEURAT_CORE_TEST_FLAGS)
+
+bool FSeuratFaceCullingTest::RunTest(const FString& Parameters)
+{
+	// A flat headbox, with minimum depths from touching the samples to sky.
+	FRandomStream Random(0xface);
+	const int32 kNumSamples = 512;
+	const int32 kNumSides = 6;
+	TArray<FVector> Samples;
+	TArray<FSeuratFaceDepthStats> FaceStats;
+	for (int32 SampleIndex = 0; SampleIndex < kNumSamples; ++SampleIndex)
+	{
+		Samples.Add(FVector(Random.FRandRange(-100.0f, 100.0f), Random.FRandRange(-50.0f, 50.0f), Random.FRandRange(-5.0f, 5.0f)));
+		for (int32 Side = 0; Side < kNumSides; ++Side)
+		{
+			FSeuratFaceDepthStats Stats;
+			Stats.GeometryFraction = Random.FRand();
+			Stats.MinDepth = FMath::Pow(10.0f, Random.FRandRange(0.0f, 6.0f));
+			FaceStats.Add(Stats);
+		}
+	}
+	FSeuratFaceCullSettings Settings;
+	Settings.Resolution = 256;
+
+	TArray<ESeuratFaceCull> Culls;
+	CullSeuratFaces(Samples, kNumSides, FaceStats, Settings, Culls);
+	TestEqual(TEXT("Faces"), Culls.Num(), kNumSamples * kNumSides);
+
+	// The grid must find exactly the faces a test against every captured face
+	// of earlier samples finds.
+	const float PixelsPerRadian = Settings.Resolution * 0.5f;
+	int32 NumMismatches = 0;
+	int32 NumRedundant = 0;
+	for (int32 Side = 0; Side < kNumSides; ++Side)
+	{
+		TArray<int32> Captured;
+		for (int32 SampleIndex = 0; SampleIndex < kNumSamples; ++SampleIndex)
+		{
+			const FSeuratFaceDepthStats& Stats = FaceStats[SampleIndex * kNumSides + Side];
+			ESeuratFaceCull Expected = ESeuratFaceCull::None;
+			if (SampleIndex > 0 && Stats.GeometryFraction < Settings.MinGeometryFraction)
+			{
+				Expected = ESeuratFaceCull::Empty;
+			}
+			else
+			{
+				for (int32 CapturedIndex : Captured)
+				{
+					const float MinDepth = FMath::Min(Stats.MinDepth, FaceStats[CapturedIndex * kNumSides + Side].MinDepth);
+					if (FVector::Dist(Samples[SampleIndex], Samples[CapturedIndex]) * PixelsPerRadian < Settings.MaxParallaxPixels * MinDepth)
+					{
+						Expected = ESeuratFaceCull::Redundant;
+						break;
+					}
+				}
+				if (Expected == ESeuratFaceCull::None)
+				{
+					Captured.Add(SampleIndex);
+				}
+			}
+			NumMismatches += Culls[SampleIndex * kNumSides + Side] != Expected ? 1 : 0;
+			NumRedundant += Expected == ESeuratFaceCull::Redundant ? 1 : 0;
+		}
+	}
+	TestEqual(TEXT("Faces culled differently from a test against every captured face"), NumMismatches, 0);
+	TestTrue(TEXT("Some faces are redundant"), NumRedundant > 0);
+
+	for (int32 Side = 0; Side < kNumSides; ++Side)
+	{
+		TestTrue(TEXT("Sides of the first sample are captured"), Culls[Side] == ESeuratFaceCull::None);
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,75 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratPack.h"
+#include "SeuratCoreTests.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSeuratPackTest, "Seurat.Core.Pack", SEURAT_CORE_TEST_FLAGS)
+
+bool FSeuratPackTest::RunTest(const FString& Parameters)
+{
+	IFileManager::Get().MakeDirectory(*FPaths::AutomationTransientDir(), true);
+	const FString Filename = FPaths::CreateTempFilename(*FPaths::AutomationTransientDir(), TEXT("SeuratPack"), TEXT(".") SEURAT_PACK_EXTENSION);
+	const uint32 kSettingsHash = 0x5eu;
+	const uint8 Image[] = { 1, 2, 3, 4 };
+	FSeuratPackEntry Entry;
+	FSeuratPackWriter Pack;
+
+	// An interrupted capture is resumed with its images.
+	TestTrue(TEXT("New pack opened"), Pack.Open(Filename, kSettingsHash, false));
+	Pack.Append(TEXT("A.exr"), Image, sizeof(Image), Entry);
+	TestTrue(TEXT("New image is resumable"), Pack.IsResumable(TEXT("A.exr")));
+	Pack.Close();
+	TestTrue(TEXT("Interrupted pack reopened"), Pack.Open(Filename, kSettingsHash, false));
+	TestTrue(TEXT("Image of the interrupted capture is resumable"), Pack.IsResumable(TEXT("A.exr")));
+	Pack.Append(TEXT("B.exr"), Image, sizeof(Image), Entry);
+	Pack.Close(true);
+
+	// Updating a completed capture keeps its images, but none is resumable, so
+	// each view is checked against the scene change.
+	TestTrue(TEXT("Complete pack opened for update"), Pack.Open(Filename, kSettingsHash, true));
+	TestTrue(TEXT("Image of the completed capture is kept"), Pack.FindEntry(TEXT("A.exr"), Entry));
+	TestFalse(TEXT("Image of the completed capture is resumable"), Pack.IsResumable(TEXT("A.exr")));
+	TestFalse(TEXT("Image of the completed capture is resumable"), Pack.IsResumable(TEXT("B.exr")));
+
+	// An interrupted update only resumes the images it rendered again.
+	Pack.Append(TEXT("A.exr"), Image, sizeof(Image), Entry);
+	Pack.Close();
+	TestTrue(TEXT("Interrupted update reopened"), Pack.Open(Filename, kSettingsHash, true));
+	TestTrue(TEXT("Image rendered by the update is resumable"), Pack.IsResumable(TEXT("A.exr")));
+	TestTrue(TEXT("Image of the updated capture is kept"), Pack.FindEntry(TEXT("B.exr"), Entry));
+	TestFalse(TEXT("Image of the updated capture is resumable"), Pack.IsResumable(TEXT("B.exr")));
+	Pack.Close(true);
+
+	// A new capture replaces a completed one.
+	TestTrue(TEXT("Complete pack opened for a new capture"), Pack.Open(Filename, kSettingsHash, false));
+	TestFalse(TEXT("Image of the completed capture is kept"), Pack.FindEntry(TEXT("A.exr"), Entry));
+	Pack.Close(true);
+
+	{
+		FSeuratPackReader Reader;
+		TestTrue(TEXT("Pack read"), Reader.Open(Filename));
+		TestTrue(TEXT("Settings hash"), Reader.GetSettingsHash() == kSettingsHash);
+		TestEqual(TEXT("Files"), Reader.GetEntries().Num(), 0);
+	}
+	IFileManager::Get().Delete(*Filename);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
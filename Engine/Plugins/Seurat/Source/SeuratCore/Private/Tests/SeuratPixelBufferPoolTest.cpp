@@ -0,0 +1,153 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratPixelBufferPool.h"
+#include "SeuratCoreTests.h"
+#include "Containers/Queue.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeCounter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// Runs a function on its own thread, like the capture's readback and the
+	// image writer threads.
+	class FTestThread : public FRunnable
+	{
+	public:
+		FTestThread(const TCHAR* Name, TFunction<void()> InBody) : Body(MoveTemp(InBody))
+		{
+			Thread = FRunnableThread::Create(this, Name);
+		}
+		virtual ~FTestThread()
+		{
+			Thread->WaitForCompletion();
+			delete Thread;
+		}
+
+		/** FRunnable implementation */
+		virtual uint32 Run() override
+		{
+			Body();
+			return 0;
+		}
+
+	private:
+		TFunction<void()> Body;
+		FRunnableThread* Thread;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSeuratPixelBufferPoolTest, "Seurat.Core.PixelBufferPool", SEURAT_CORE_TEST_FLAGS)
+
+bool FSeuratPixelBufferPoolTest::RunTest(const FString& Parameters)
+{
+	if (!FPlatformProcess::SupportsMultithreading())
+	{
+		AddWarning(TEXT("The pixel buffer pool test needs threads."));
+		return true;
+	}
+
+	const int32 kNumPixels = 64 * 64;
+	const int32 kNumImages = 200;
+	// The producer holds back, like capture does for the image writer, while
+	// this many buffers are in flight.
+	const int32 kMaxBuffersInFlight = 4;
+	const int64 kBudgetBytes = static_cast<int64>(kMaxBuffersInFlight) * kNumPixels * sizeof(FFloat16Color);
+
+	FSeuratPixelBufferPool Pool;
+	Pool.Configure(kNumPixels);
+
+	TQueue<TArray<FFloat16Color>, EQueueMode::Spsc> Images;
+	FThreadSafeCounter NumInFlight;
+	FThreadSafeCounter NumWrongSize;
+	FThreadSafeCounter NumOutOfOrder;
+	{
+		FTestThread Producer(TEXT("SeuratPoolTestProducer"), [&]()
+		{
+			for (int32 ImageIndex = 0; ImageIndex < kNumImages; ++ImageIndex)
+			{
+				while (NumInFlight.GetValue() >= kMaxBuffersInFlight)
+				{
+					FPlatformProcess::Sleep(0.0f);
+				}
+				NumInFlight.Increment();
+				TArray<FFloat16Color> Buffer = Pool.Acquire();
+				if (Buffer.Num() != kNumPixels)
+				{
+					NumWrongSize.Increment();
+				}
+				Buffer[0].R = FFloat16(static_cast<float>(ImageIndex));
+				Images.Enqueue(MoveTemp(Buffer));
+			}
+		});
+		FTestThread Consumer(TEXT("SeuratPoolTestConsumer"), [&]()
+		{
+			for (int32 ImageIndex = 0; ImageIndex < kNumImages; )
+			{
+				TArray<FFloat16Color> Buffer;
+				if (!Images.Dequeue(Buffer))
+				{
+					FPlatformProcess::Sleep(0.0f);
+					continue;
+				}
+				if (Buffer.Num() != kNumPixels || Buffer[0].R.GetFloat() != static_cast<float>(ImageIndex))
+				{
+					NumOutOfOrder.Increment();
+				}
+				Pool.Release(MoveTemp(Buffer));
+				NumInFlight.Decrement();
+				++ImageIndex;
+			}
+		});
+	}
+
+	FSeuratPixelBufferPoolStats Stats = Pool.GetStats();
+	TestEqual(TEXT("Buffers of the wrong size"), NumWrongSize.GetValue(), 0);
+	TestEqual(TEXT("Buffers received out of order"), NumOutOfOrder.GetValue(), 0);
+	TestTrue(TEXT("Every image acquires a buffer"), Stats.NumAcquires == kNumImages);
+	TestTrue(TEXT("Buffers are reused rather than reallocated"), Stats.NumAllocations <= kMaxBuffersInFlight);
+	TestTrue(TEXT("Buffers in use stay within the budget"), Stats.PeakBytesInUse <= kBudgetBytes);
+	TestEqual(TEXT("Buffers in use after the consumer finishes"), Stats.NumInUse, 0);
+	TestEqual(TEXT("Buffers pooled after the consumer finishes"), Stats.NumAllocated, static_cast<int32>(Stats.NumAllocations));
+
+	// Configuring the same size keeps the pooled buffers.
+	Pool.Configure(kNumPixels);
+	TestEqual(TEXT("Buffers pooled after configuring the same size"), Pool.GetStats().NumAllocated, Stats.NumAllocated);
+
+	// A buffer in use when the size changes is freed when it is released, and
+	// pooled buffers of the old size are freed right away.
+	TArray<FFloat16Color> OldBuffer = Pool.Acquire();
+	Pool.Configure(kNumPixels / 4);
+	TestEqual(TEXT("Buffers allocated after a size change"), Pool.GetStats().NumAllocated, 1);
+	Pool.Release(MoveTemp(OldBuffer));
+	Stats = Pool.GetStats();
+	TestEqual(TEXT("Buffers allocated after releasing a buffer of the old size"), Stats.NumAllocated, 0);
+	TestEqual(TEXT("Buffers in use after releasing a buffer of the old size"), Stats.NumInUse, 0);
+
+	TArray<FFloat16Color> NewBuffer = Pool.Acquire();
+	TestEqual(TEXT("Pixels of a buffer of the new size"), NewBuffer.Num(), kNumPixels / 4);
+	Pool.Release(MoveTemp(NewBuffer));
+	TestEqual(TEXT("Buffers pooled at the new size"), Pool.GetStats().NumAllocated, 1);
+
+	Pool.Trim();
+	TestEqual(TEXT("Buffers allocated after trimming"), Pool.GetStats().NumAllocated, 0);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
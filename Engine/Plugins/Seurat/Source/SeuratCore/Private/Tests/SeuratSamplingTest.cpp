@@ -0,0 +1,132 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SeuratSampling.h"
+#include "SeuratCoreTests.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// The radical inverse of the original capture code, which Hammersley samples
+// must reproduce bit for bit to keep settings hashes and captures valid.
+static float BaselineRadicalInverse(uint64 A, uint64 DigitBase)
+{
+	float InvBase = 1.0f / DigitBase;
+	uint64 ReversedDigits = 0;
+	float InvBaseN = 1.0f;
+	while (A != 0)
+	{
+		uint64 Next = A / DigitBase;
+		uint64 Digit = A - Next * DigitBase;
+		ReversedDigits = ReversedDigits * DigitBase + Digit;
+		InvBaseN *= InvBase;
+		A = Next;
+	}
+	return FMath::Min(ReversedDigits * InvBaseN, 1.0f);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSeuratSamplingTest, "Seurat.Core.Sampling", SEURAT_CORE_TEST_FLAGS)
+
+bool FSeuratSamplingTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("Radical inverse of 1 in base 3"), RadicalInverse(1, 3), 0.33333334f);
+
+	int32 NumMismatches = 0;
+	for (uint64 Index = 0; Index < (1ull << 32); Index += Index < 65536 ? 1 : 65537)
+	{
+		for (uint64 Base : { 2, 3 })
+		{
+			if (RadicalInverse(Index, Base) != BaselineRadicalInverse(Index, Base))
+			{
+				++NumMismatches;
+			}
+		}
+	}
+	TestEqual(TEXT("Radical inverses that differ from the original code"), NumMismatches, 0);
+
+	// Hammersley samples are the radical inverses, before the sort by distance.
+	const int32 kNumSamples = 1000;
+	const FVector HeadboxSize(100.0f, 100.0f, 100.0f);
+	TArray<FVector> Samples;
+	GenerateHeadboxSamples(kNumSamples, HeadboxSize, FTransform::Identity, Samples);
+	TestEqual(TEXT("Samples"), Samples.Num(), kNumSamples);
+	TestEqual(TEXT("First sample"), Samples[0], FVector::ZeroVector);
+	int32 NumMissing = 0;
+	for (int32 SampleIndex = 1; SampleIndex < kNumSamples; ++SampleIndex)
+	{
+		const FVector Expected = FVector(
+			(float)SampleIndex / (float)(kNumSamples - 1),
+			BaselineRadicalInverse(SampleIndex, 2),
+			BaselineRadicalInverse(SampleIndex, 3)) * HeadboxSize - HeadboxSize * 0.5f;
+		if (!Samples.Contains(Expected))
+		{
+			++NumMissing;
+		}
+	}
+	// The sample nearest the center is replaced by the center.
+	TestTrue(TEXT("Hammersley samples that differ from the original code"), NumMissing <= 1);
+
+	// A flat, rotated headbox keeps the original samples, sorted by world
+	// distance, so captures without resolution falloff keep their views.
+	const FVector FlatHeadboxSize(400.0f, 100.0f, 20.0f);
+	const FTransform FlatHeadboxToWorld(FRotator(10.0f, 30.0f, 0.0f), FVector(100.0f, -200.0f, 50.0f));
+	TestFalse(TEXT("Flat headbox is a cube"), IsHeadboxCube(FlatHeadboxSize, FlatHeadboxToWorld));
+	TestTrue(TEXT("Cube headbox is a cube"), IsHeadboxCube(HeadboxSize, FlatHeadboxToWorld));
+	const FVector CameraLocation = FlatHeadboxToWorld.GetLocation();
+	TArray<FVector> Expected;
+	for (int32 SampleIndex = 0; SampleIndex < kNumSamples; ++SampleIndex)
+	{
+		Expected.Add(FlatHeadboxToWorld.TransformPosition(FVector(
+			(float)SampleIndex / (float)(kNumSamples - 1),
+			BaselineRadicalInverse(SampleIndex, 2),
+			BaselineRadicalInverse(SampleIndex, 3)) * FlatHeadboxSize - FlatHeadboxSize * 0.5f));
+	}
+	Expected.StableSort([&CameraLocation](const FVector& V1, const FVector& V2) {
+		return (V1 - CameraLocation).SizeSquared() < (V2 - CameraLocation).SizeSquared();
+	});
+	Expected[0] = CameraLocation;
+	GenerateHeadboxSamples(kNumSamples, FlatHeadboxSize, FlatHeadboxToWorld, Samples);
+	TestTrue(TEXT("Samples of a flat headbox are the original samples"), Samples == Expected);
+
+	// Sorted for resolution falloff, resolution levels never increase in sample
+	// order, so captures issue views from the highest resolution down. The
+	// samples stay the same.
+	for (ESeuratSamplePattern Pattern : { ESeuratSamplePattern::Hammersley, ESeuratSamplePattern::ScrambledSobol })
+	{
+		GenerateHeadboxSamples(kNumSamples, FlatHeadboxSize, FlatHeadboxToWorld, Samples, Pattern, 7);
+		TArray<FVector> Sorted = Samples;
+		SortSamplesForResolutionFalloff(Sorted, FlatHeadboxSize, FlatHeadboxToWorld);
+		TestEqual(TEXT("Center sample"), Sorted[0], CameraLocation);
+		int32 NumMissing = 0;
+		for (const FVector& Sample : Samples)
+		{
+			NumMissing += Sorted.Contains(Sample) ? 0 : 1;
+		}
+		TestEqual(TEXT("Samples lost by the sort"), NumMissing, 0);
+		Samples = MoveTemp(Sorted);
+		int32 NumIncreases = 0;
+		int32 PreviousLevel = 0;
+		for (const FVector& Sample : Samples)
+		{
+			const int32 Level = GetSampleResolutionLevel(Sample, FlatHeadboxSize, FlatHeadboxToWorld, 0.25f, 3);
+			NumIncreases += Level < PreviousLevel ? 1 : 0;
+			PreviousLevel = Level;
+		}
+		TestEqual(TEXT("Samples with a higher resolution than the previous sample"), NumIncreases, 0);
+		TestEqual(TEXT("Resolution level of the last sample"), PreviousLevel, 3);
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
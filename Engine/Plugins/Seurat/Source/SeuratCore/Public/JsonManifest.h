@@ -0,0 +1,228 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+
+template <class PrintPolicy>
+static void WriteMatrixJson(TJsonWriter<TCHAR, PrintPolicy>& Writer, const FString& Identifier, const FMatrix& Matrix)
+{
+	Writer.WriteArrayStart(Identifier);
+	for (int32 i = 0; i<4; i++)
+		for (int32 j = 0; j < 4; j++)
+		{
+			Writer.WriteValue(static_cast<double>(Matrix.M[j][i]));
+		}
+	Writer.WriteArrayEnd();
+}
+
+class ProjectiveCamera {
+public:
+	int32 ImageWidth;
+	int32 ImageHeight;
+	FMatrix ClipFromEyeMatrix;
+	FMatrix WorldFromEyeMatrix;
+	FString DepthType;
+	template <class PrintPolicy>
+	void WriteJson(TJsonWriter<TCHAR, PrintPolicy>& Writer, const FString& Identifier) const
+	{
+		Writer.WriteObjectStart(Identifier);
+		Writer.WriteValue(TEXT("image_width"), ImageWidth);
+		Writer.WriteValue(TEXT("image_height"), ImageHeight);
+		WriteMatrixJson(Writer, TEXT("clip_from_eye_matrix"), ClipFromEyeMatrix);
+		WriteMatrixJson(Writer, TEXT("world_from_eye_matrix"), WorldFromEyeMatrix);
+		Writer.WriteValue(TEXT("depth_type"), DepthType);
+		Writer.WriteObjectEnd();
+	}
+};
+
+// Where an image file is stored in the capture's pack, if it has one.
+class PackLocation {
+public:
+	// Negative if the file is not in a pack.
+	int64 Offset;
+	int64 Size;
+	PackLocation() : Offset(-1), Size(0) {}
+	template <class PrintPolicy>
+	void WriteJson(TJsonWriter<TCHAR, PrintPolicy>& Writer) const
+	{
+		if (Offset >= 0)
+		{
+			Writer.WriteValue(TEXT("pack_offset"), static_cast<double>(Offset));
+			Writer.WriteValue(TEXT("pack_size"), static_cast<double>(Size));
+		}
+	}
+};
+
+class Image4File {
+public:
+	FString Path;
+	FString Channel0;
+	FString Channel1;
+	FString Channel2;
+	FString ChannelAlpha;
+	PackLocation Pack;
+	template <class PrintPolicy>
+	void WriteJson(TJsonWriter<TCHAR, PrintPolicy>& Writer, const FString& Identifier) const
+	{
+		Writer.WriteObjectStart(Identifier);
+		Writer.WriteValue(TEXT("path"), Path);
+		Writer.WriteValue(TEXT("channel_0"), Channel0);
+		Writer.WriteValue(TEXT("channel_1"), Channel1);
+		Writer.WriteValue(TEXT("channel_2"), Channel2);
+		Writer.WriteValue(TEXT("channel_alpha"), ChannelAlpha);
+		Pack.WriteJson(Writer);
+		Writer.WriteObjectEnd();
+	}
+};
+
+class Image1File {
+public:
+	FString Path;
+	FString Channel0;
+	PackLocation Pack;
+	template <class PrintPolicy>
+	void WriteJson(TJsonWriter<TCHAR, PrintPolicy>& Writer, const FString& Identifier) const
+	{
+		Writer.WriteObjectStart(Identifier);
+		Writer.WriteValue(TEXT("path"), Path);
+		Writer.WriteValue(TEXT("channel_0"), Channel0);
+		Pack.WriteJson(Writer);
+		Writer.WriteObjectEnd();
+	}
+};
+
+class DepthImageFile {
+public:
+	Image4File Color;
+	Image1File Depth;
+	template <class PrintPolicy>
+	void WriteJson(TJsonWriter<TCHAR, PrintPolicy>& Writer, const FString& Identifier) const
+	{
+		Writer.WriteObjectStart(Identifier);
+		Color.WriteJson(Writer, TEXT("color"));
+		Depth.WriteJson(Writer, TEXT("depth"));
+		Writer.WriteObjectEnd();
+	}
+};
+
+class SeuratView {
+public:
+	ProjectiveCamera ProjectiveCamera;
+	DepthImageFile DepthImageFile;
+	template <class PrintPolicy>
+	void WriteJson(TJsonWriter<TCHAR, PrintPolicy>& Writer) const
+	{
+		Writer.WriteObjectStart();
+		ProjectiveCamera.WriteJson(Writer, TEXT("projective_camera"));
+		DepthImageFile.WriteJson(Writer, TEXT("depth_image_file"));
+		Writer.WriteObjectEnd();
+	}
+};
+
+// A side of a view group that was not captured, and why.
+class SeuratCulledFace {
+public:
+	FString Face;
+	FString Reason;
+	template <class PrintPolicy>
+	void WriteJson(TJsonWriter<TCHAR, PrintPolicy>& Writer) const
+	{
+		Writer.WriteObjectStart();
+		Writer.WriteValue(TEXT("face"), Face);
+		Writer.WriteValue(TEXT("reason"), Reason);
+		Writer.WriteObjectEnd();
+	}
+};
+
+// A view group of a manifest read from disk.
+struct FSeuratManifestViewGroup
+{
+	TArray<SeuratView> Views;
+	TArray<SeuratCulledFace> CulledFaces;
+};
+
+// The views one shard of a capture covers, when a capture is split across
+// processes. Views are numbered in capture order: sample by sample, with
+// ViewsPerGroup views per sample in the order of the sides. The manifest of a
+// shard holds a view group for each sample its range touches, with only the
+// views and culled faces in the range.
+struct FSeuratManifestShard
+{
+	int32 FirstView;
+	int32 EndView;
+	// Views of the whole capture.
+	int32 NumViews;
+	int32 ViewsPerGroup;
+	// Shards of the same capture have the same settings hash.
+	uint32 SettingsHash;
+
+	FSeuratManifestShard() : FirstView(0), EndView(0), NumViews(0), ViewsPerGroup(0), SettingsHash(0) {}
+
+	bool IsValid() const { return NumViews > 0 && ViewsPerGroup > 0; }
+};
+
+// Reads the view groups of a manifest written by FSeuratManifestWriter, pretty
+// or compact, the path of the pack that holds its images, if any, and the
+// views it covers if it is the manifest of a shard. Returns false if the file
+// cannot be read or parsed.
+SEURATCORE_API bool ReadSeuratManifest(const FString& Filename, TArray<FSeuratManifestViewGroup>& OutViewGroups, FString* OutPackPath = nullptr, FSeuratManifestShard* OutShard = nullptr);
+
+// Combines the manifests of the shards of a capture into the view groups of
+// the manifest a single capture writes. The shards must cover every view of
+// the capture exactly once; they may be given in any order.
+SEURATCORE_API bool MergeSeuratManifestShards(const TArray<FString>& ShardFilenames, TArray<FSeuratManifestViewGroup>& OutViewGroups);
+
+// Writes manifest.json incrementally, one view group at a time, so the views of
+// a capture never have to be held in memory together. After every appended
+// group the file holds a complete, valid manifest of the groups written so far:
+// each append overwrites the closing brackets and writes them again, so a
+// capture that stops midway still leaves a usable partial manifest.
+class SEURATCORE_API FSeuratManifestWriter
+{
+public:
+	FSeuratManifestWriter();
+	~FSeuratManifestWriter();
+
+	// Creates the manifest file, replacing any existing one. Compact manifests
+	// are written without whitespace. If the images are in a pack, |PackPath|
+	// is its path relative to the manifest, and the images record their pack
+	// locations. The manifest of a shard records the views it covers.
+	bool Open(const FString& Filename, bool bInCompact, const FString& PackPath = FString(), const FSeuratManifestShard* Shard = nullptr);
+	// Culled faces are recorded in the group's culled_faces array, which is only
+	// written if there are any.
+	bool AppendViewGroup(const TArray<SeuratView>& Views, const TArray<SeuratCulledFace>& CulledFaces = TArray<SeuratCulledFace>());
+	void Close();
+
+	bool IsOpen() const { return Archive.IsValid(); }
+	int32 GetNumViewGroups() const { return NumViewGroups; }
+
+	// Serializes a view group object the way AppendViewGroup writes it.
+	static FString ViewGroupToString(const TArray<SeuratView>& Views, bool bCompact, const TArray<SeuratCulledFace>& CulledFaces = TArray<SeuratCulledFace>());
+
+private:
+	bool WriteText(const FString& Text);
+	bool WriteTrailer();
+
+	TUniquePtr<FArchive> Archive;
+	bool bCompact;
+	int32 NumViewGroups;
+	// Offset of the closing brackets, which the next group overwrites.
+	int64 TrailerOffset;
+};
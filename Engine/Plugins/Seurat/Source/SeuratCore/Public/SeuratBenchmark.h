@@ -0,0 +1,103 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Timing of one benchmark.
+struct FSeuratBenchmarkResult
+{
+	FString Name;
+	// Items processed by one iteration, e.g. samples generated or views written.
+	int64 ItemsPerIteration;
+	int32 Iterations;
+	double SecondsPerIteration;
+
+	FSeuratBenchmarkResult() : ItemsPerIteration(1), Iterations(0), SecondsPerIteration(0.0) {}
+
+	double GetItemsPerSecond() const { return SecondsPerIteration > 0.0 ? ItemsPerIteration / SecondsPerIteration : 0.0; }
+	double GetNanosecondsPerItem() const { return SecondsPerIteration * 1.0e9 / FMath::Max<int64>(ItemsPerIteration, 1); }
+};
+
+// Runs |Body| repeatedly until |MinSeconds| have passed, at least once, and
+// returns the mean time per iteration. Like Google Benchmark, the iteration
+// count adapts to the cost of the body, so cheap and expensive benchmarks are
+// measured with similar accuracy.
+SEURATCORE_API FSeuratBenchmarkResult RunSeuratBenchmark(const FString& Name, int64 ItemsPerIteration, double MinSeconds, TFunctionRef<void()> Body);
+
+// A depth map to compress in the depth codec benchmarks.
+struct FSeuratBenchmarkDepthImage
+{
+	FString Name;
+	int32 Width;
+	int32 Height;
+	TArray<float> Depths;
+
+	FSeuratBenchmarkDepthImage() : Width(0), Height(0) {}
+};
+
+// Parameters of the benchmark suite.
+struct FSeuratBenchmarkOptions
+{
+	// Headbox sample counts to generate.
+	TArray<int32> SampleCounts;
+	// Matrices converted per iteration.
+	int32 NumMatrices;
+	// View counts to serialize as manifests.
+	TArray<int32> ViewCounts;
+	// Sizes of the square synthetic depth maps to compress.
+	TArray<int32> DepthSizes;
+	// Captured depth maps to compress, in addition to the synthetic ones.
+	TArray<FSeuratBenchmarkDepthImage> DepthImages;
+	// Directory whose encoded depth images are compressed too, if not empty.
+	FString DepthImageDirectory;
+	double MinSeconds;
+	// Only benchmarks whose name contains this are run, if it is not empty.
+	FString Filter;
+	// JSON file the results are written to, if not empty.
+	FString OutputFilename;
+
+	FSeuratBenchmarkOptions() : NumMatrices(100000), MinSeconds(0.5)
+	{
+		SampleCounts = { 256, 65536, 1048576 };
+		ViewCounts = { 1536, 12288 };
+		DepthSizes = { 1024, 4096 };
+	}
+};
+
+// Runs the benchmarks of the engine independent capture code: sample
+// generation, matrix conversion, manifest serialization and depth coding.
+// Returns false if a benchmark computes a wrong result, e.g. depth that does
+// not round trip through the depth codec.
+SEURATCORE_API bool RunSeuratCoreBenchmarks(const FSeuratBenchmarkOptions& Options, TArray<FSeuratBenchmarkResult>& OutResults);
+
+// Reads benchmark options from a command line:
+//   [-Samples=256,65536] [-Views=1536,12288] [-Matrices=Count]
+//   [-MinTime=Seconds] [-Filter=Name] [-DepthSizes=1024,4096]
+//   [-DepthImages=CaptureDirectory] [-Output=Results.json]
+SEURATCORE_API void ParseSeuratBenchmarkOptions(const TCHAR* CommandLine, FSeuratBenchmarkOptions& OutOptions);
+
+// Reads the encoded depth images in |Directory|.
+SEURATCORE_API void LoadSeuratBenchmarkDepthImages(const FString& Directory, TArray<FSeuratBenchmarkDepthImage>& OutImages);
+
+SEURATCORE_API bool SaveSeuratBenchmarkResults(const FString& Filename, const TArray<FSeuratBenchmarkResult>& Results);
+
+// Runs the benchmarks and saves their results, as the benchmark commandlet and
+// the Seurat.Benchmark console command do. Only needs SeuratCore, so it runs
+// headless on every platform. Returns a process exit code: non-zero if no
+// benchmark matches the filter, a result is wrong or the results cannot be
+// saved.
+SEURATCORE_API int32 RunSeuratBenchmarkSuite(const FSeuratBenchmarkOptions& Options);
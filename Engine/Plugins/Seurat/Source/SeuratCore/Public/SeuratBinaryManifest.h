@@ -0,0 +1,175 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "JsonManifest.h"
+
+// Binary equivalent of manifest.json, laid out to be memory mapped and used in
+// place: views are fixed size records, so view N is found without parsing the
+// views before it, and matrices are stored as floats rather than text.
+//
+// Layout, little endian, every section 16 byte aligned:
+//   FSeuratBinaryManifestHeader
+//   FSeuratBinaryViewGroup[NumViewGroups]
+//   FSeuratBinaryView[NumViews], in manifest order
+//   FSeuratBinaryCulledFace[NumCulledFaces]
+//   String table: null terminated UTF-8 strings, referenced by byte offset.
+//   Offset 0 is the empty string, and equal strings are stored once.
+
+#define SEURAT_BINARY_MANIFEST_EXTENSION TEXT("smnf")
+
+struct FSeuratBinaryManifestHeader
+{
+	// "SMNF".
+	uint8 Magic[4];
+	uint32 Version;
+	uint32 NumViewGroups;
+	uint32 NumViews;
+	uint32 NumCulledFaces;
+	uint32 StringTableSize;
+	// Byte offsets of the sections from the start of the file.
+	uint64 ViewGroupsOffset;
+	uint64 ViewsOffset;
+	uint64 CulledFacesOffset;
+	uint64 StringTableOffset;
+	// String table offset of the path of the capture's pack, if any.
+	uint32 PackPath;
+	uint32 Reserved;
+};
+
+struct FSeuratBinaryViewGroup
+{
+	uint32 FirstView;
+	uint32 NumViews;
+	uint32 FirstCulledFace;
+	uint32 NumCulledFaces;
+};
+
+struct FSeuratBinaryView
+{
+	int32 ImageWidth;
+	int32 ImageHeight;
+	// In the element order of the JSON arrays, i.e. column major.
+	float ClipFromEyeMatrix[16];
+	float WorldFromEyeMatrix[16];
+	// String table offsets.
+	uint32 DepthType;
+	uint32 ColorPath;
+	uint32 ColorChannels[4];
+	uint32 DepthPath;
+	uint32 DepthChannel0;
+	// Group the view belongs to.
+	uint32 ViewGroup;
+	uint32 Reserved;
+	// Pack locations of the images, with negative offsets if not packed.
+	int64 ColorPackOffset;
+	int64 ColorPackSize;
+	int64 DepthPackOffset;
+	int64 DepthPackSize;
+};
+
+struct FSeuratBinaryCulledFace
+{
+	uint32 Face;
+	uint32 Reason;
+};
+
+static_assert(sizeof(FSeuratBinaryManifestHeader) == 64, "Binary manifest header must match the file layout.");
+static_assert(sizeof(FSeuratBinaryView) == 208, "Binary manifest views must match the file layout.");
+
+// Builds a binary manifest from view groups, in the order they are added.
+class SEURATCORE_API FSeuratBinaryManifestBuilder
+{
+public:
+	FSeuratBinaryManifestBuilder();
+
+	void Reset();
+	void SetPackPath(const FString& InPackPath);
+	void AddViewGroup(const TArray<SeuratView>& Views, const TArray<SeuratCulledFace>& CulledFaces = TArray<SeuratCulledFace>());
+
+	int32 GetNumViewGroups() const { return ViewGroups.Num(); }
+
+	void Serialize(TArray<uint8>& OutData) const;
+	bool Save(const FString& Filename) const;
+
+private:
+	// Paths and channel names are case sensitive, unlike FString keys.
+	struct FStringKeyFuncs : TDefaultMapKeyFuncs<FString, uint32, false>
+	{
+		static bool Matches(const FString& A, const FString& B) { return A.Equals(B, ESearchCase::CaseSensitive); }
+		static uint32 GetKeyHash(const FString& Key) { return FCrc::StrCrc32(*Key); }
+	};
+
+	uint32 AddString(const FString& String);
+
+	TArray<FSeuratBinaryViewGroup> ViewGroups;
+	TArray<FSeuratBinaryView> Views;
+	TArray<FSeuratBinaryCulledFace> CulledFaces;
+	TArray<ANSICHAR> StringTable;
+	TMap<FString, uint32, FDefaultSetAllocator, FStringKeyFuncs> StringOffsets;
+	// String table offset of the pack path.
+	uint32 PackPath;
+};
+
+// Reads a binary manifest in place. Opening only checks the header and section
+// bounds, so it takes constant time however many views the manifest has.
+class SEURATCORE_API FSeuratBinaryManifest
+{
+public:
+	FSeuratBinaryManifest();
+	// The views point into the data, which a copy would not own.
+	FSeuratBinaryManifest(const FSeuratBinaryManifest&) = delete;
+	FSeuratBinaryManifest& operator=(const FSeuratBinaryManifest&) = delete;
+
+	// Uses |InData| without copying it, e.g. a memory mapped file. The data must
+	// stay valid and be at least 8 byte aligned while the manifest is used.
+	bool Initialize(const uint8* InData, int64 InDataSize);
+	// Reads the manifest file into memory.
+	bool Load(const FString& Filename);
+
+	int32 GetNumViewGroups() const { return Header != nullptr ? Header->NumViewGroups : 0; }
+	int32 GetNumViews() const { return Header != nullptr ? Header->NumViews : 0; }
+	// Empty if the images are not in a pack.
+	const ANSICHAR* GetPackPath() const { return GetString(Header != nullptr ? Header->PackPath : 0); }
+
+	const FSeuratBinaryViewGroup& GetViewGroup(int32 GroupIndex) const;
+	// Views are numbered in manifest order across all groups.
+	const FSeuratBinaryView& GetView(int32 ViewIndex) const;
+	const FSeuratBinaryCulledFace& GetCulledFace(int32 CulledFaceIndex) const;
+	// Returns the empty string for offsets outside the string table.
+	const ANSICHAR* GetString(uint32 Offset) const;
+
+	SeuratView ToSeuratView(int32 ViewIndex) const;
+	// Converts a group to the views and culled faces of the JSON manifest.
+	void ReadViewGroup(int32 GroupIndex, TArray<SeuratView>& OutViews, TArray<SeuratCulledFace>& OutCulledFaces) const;
+
+private:
+	TArray<uint8> OwnedData;
+	const FSeuratBinaryManifestHeader* Header;
+	const FSeuratBinaryViewGroup* ViewGroups;
+	const FSeuratBinaryView* Views;
+	const FSeuratBinaryCulledFace* CulledFaces;
+	const ANSICHAR* StringTable;
+};
+
+// Converts between manifest.json and the binary manifest. The format of each
+// file follows from its extension.
+SEURATCORE_API bool ConvertSeuratManifest(const FString& InputFilename, const FString& OutputFilename, bool bCompactJson = false);
+
+// Writes view groups as manifest.json or as a binary manifest, following the
+// extension of |Filename|.
+SEURATCORE_API bool WriteSeuratManifest(const FString& Filename, const TArray<FSeuratManifestViewGroup>& ViewGroups, const FString& PackPath = FString(), bool bCompactJson = false);
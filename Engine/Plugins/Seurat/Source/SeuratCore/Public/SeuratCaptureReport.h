@@ -0,0 +1,64 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Where the time of one captured view went, in seconds.
+struct FSeuratViewTiming
+{
+	// Image file name, as listed in the manifest.
+	FString Path;
+	// Game thread time spent placing the camera and enqueueing the capture and
+	// readback. Views of a single pass cube capture share its time evenly.
+	double IssueSeconds;
+	// Time from enqueueing the readback until it completed, which includes
+	// rendering the view.
+	double ReadbackSeconds;
+	double EncodeSeconds;
+	double WriteSeconds;
+	int64 BytesWritten;
+
+	FSeuratViewTiming() : IssueSeconds(0.0), ReadbackSeconds(0.0), EncodeSeconds(0.0), WriteSeconds(0.0), BytesWritten(0) {}
+};
+
+// Collects per-view timings of a capture and writes them, with totals and
+// throughput, to a JSON report. Comparing reports shows how capture speed
+// changes across engine versions and settings.
+class SEURATCORE_API FSeuratCaptureReport
+{
+public:
+	FSeuratCaptureReport();
+
+	// Clears the report and starts timing the capture.
+	void Begin();
+	// Stops timing the capture.
+	void End();
+
+	FSeuratViewTiming& FindOrAddView(const FString& Path);
+
+	int32 GetNumViews() const { return Views.Num(); }
+	double GetTotalSeconds() const { return EndTime - StartTime; }
+	int64 GetBytesWritten() const;
+
+	bool Save(const FString& Filename) const;
+
+private:
+	double StartTime;
+	double EndTime;
+	TArray<FSeuratViewTiming> Views;
+	TMap<FString, int32> ViewIndices;
+};
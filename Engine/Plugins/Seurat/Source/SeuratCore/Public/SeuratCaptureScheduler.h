@@ -0,0 +1,83 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Signals that the renderer has finished the work issued for a capture job.
+// The scheduler only polls fences, so tests can drive it with a fake fence that
+// completes whenever they choose.
+class ISeuratCaptureFence
+{
+public:
+	virtual ~ISeuratCaptureFence() {}
+	virtual bool IsComplete() const = 0;
+};
+
+// One view of the capture: a face of the cube at a headbox sample, or one
+// tile of it if the view is rendered in tiles.
+struct FSeuratCaptureJob
+{
+	int32 SampleIndex;
+	int32 SideIndex;
+	int32 TileIndex;
+
+	FSeuratCaptureJob() : SampleIndex(0), SideIndex(0), TileIndex(0) {}
+	FSeuratCaptureJob(int32 InSampleIndex, int32 InSideIndex, int32 InTileIndex = 0) : SampleIndex(InSampleIndex), SideIndex(InSideIndex), TileIndex(InTileIndex) {}
+};
+
+// Issues capture jobs as soon as the renderer can take them instead of on a
+// fixed frame cadence. Jobs are issued in order, several per tick if allowed,
+// and retire when their fence signals. This class has no engine dependencies.
+class SEURATCORE_API FSeuratCaptureScheduler
+{
+public:
+	FSeuratCaptureScheduler();
+
+	// Builds the job list, sample-major, and resets progress. SampleTileCounts
+	// gives the number of tiles of each view of a sample, one if empty.
+	void Reset(int32 NumSamples, int32 NumSides, int32 InMaxJobsPerTick, int32 InMaxJobsInFlight, const TArray<int32>& SampleTileCounts = TArray<int32>());
+
+	// Drops the jobs for which IsDone returns true, e.g. views already captured
+	// by an interrupted capture. Must be called before the first Tick. Returns
+	// the number of jobs dropped.
+	int32 RemoveJobs(TFunctionRef<bool(const FSeuratCaptureJob&)> IsDone);
+
+	// Retires jobs whose fence has signalled, then issues pending jobs until the
+	// per-tick or in-flight limit is reached or CanIssue returns false. Issue
+	// must return the fence of the work it enqueued. Returns the number of jobs
+	// issued.
+	int32 Tick(TFunctionRef<bool()> CanIssue, TFunctionRef<TSharedRef<ISeuratCaptureFence>(const FSeuratCaptureJob&)> Issue);
+
+	// True once every job has been issued and has retired.
+	bool IsComplete() const;
+
+	int32 GetNumJobs() const { return Jobs.Num(); }
+	int32 GetNumIssued() const { return NextJob; }
+	int32 GetNumRetired() const { return NumRetired; }
+	int32 GetNumInFlight() const { return InFlight.Num(); }
+
+private:
+	void RetireCompletedJobs();
+
+	TArray<FSeuratCaptureJob> Jobs;
+	// Fences of issued jobs that have not retired yet, oldest first.
+	TArray<TSharedRef<ISeuratCaptureFence>> InFlight;
+	int32 NextJob;
+	int32 NumRetired;
+	int32 MaxJobsPerTick;
+	int32 MaxJobsInFlight;
+};
@@ -0,0 +1,62 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Records which capture images have been written, so an interrupted capture
+// can resume without rendering them again. The checkpoint is a text file next
+// to the manifest: a header line with a hash of the capture settings, followed
+// by one line per written image with its size and file name. Records of a
+// checkpoint with a different settings hash are discarded.
+class SEURATCORE_API FSeuratCaptureCheckpoint
+{
+public:
+	FSeuratCaptureCheckpoint();
+	~FSeuratCaptureCheckpoint();
+
+	// Hashes the settings that determine the views of a capture. The default
+	// sample pattern and seed leave the hash of earlier versions unchanged.
+	static uint32 HashSettings(const FTransform& CameraTransform, const FVector& HeadboxSize, int32 Resolution, int32 NumSamples, int32 CaptureMode,
+		int32 SamplePattern = 0, uint32 SampleSeed = 0);
+
+	// Loads the records of an existing checkpoint with the same settings hash
+	// whose images are still valid, and rewrites the file with just those
+	// records. Returns false if the file cannot be written.
+	bool Open(const FString& InFilename, uint32 InSettingsHash);
+	void Close();
+	// Closes and deletes the checkpoint, e.g. once the capture has completed.
+	void Delete();
+
+	bool IsOpen() const { return Archive.IsValid(); }
+
+	// Whether the image was recorded and is still on disk with the recorded size.
+	bool IsImageComplete(const FString& ImageFilename) const;
+	// Records a written image. The record is flushed to disk immediately.
+	void MarkImageComplete(const FString& ImageFilename, int64 SizeBytes);
+
+	int32 GetNumCompleteImages() const { return CompletedImages.Num(); }
+
+private:
+	bool WriteLine(const FString& Line);
+
+	FString Filename;
+	uint32 SettingsHash;
+	// Recorded size of each written image, keyed by its file name relative to
+	// the checkpoint directory.
+	TMap<FString, int64> CompletedImages;
+	TUniquePtr<FArchive> Archive;
+};
@@ -0,0 +1,48 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Lossless codec for eye space depth images. Depth is mostly smooth, so each
+// pixel is predicted from its left, upper and upper left neighbors with the
+// median edge detector of LOCO-I, which fits a plane through them except at
+// depth edges. The prediction residuals are Rice coded in blocks, each with its
+// own Rice parameter.
+//
+// Coding works on the float bit patterns, so decoding reproduces every value
+// bit for bit, including infinities and NaNs. Low mantissa bits that are zero
+// in every pixel, as in depth read back at half precision, are not stored.
+//
+// Encoded layout, little endian:
+//   char[4] "SDPT", uint8 version, uint8 shift, uint8 flags, uint8 reserved,
+//   uint32 width, uint32 height, then the bit stream of the residuals.
+
+// File extension of encoded depth images.
+#define SEURAT_DEPTH_EXTENSION TEXT("sdepth")
+
+// Encodes |Width| x |Height| depths, in rows from the top. Images without
+// pixels are encoded as 0 x 0.
+SEURATCORE_API void EncodeSeuratDepth(const float* Depths, int32 Width, int32 Height, TArray<uint8>& OutData);
+
+// Reads the image size of encoded depth. Returns false if |Data| is not
+// encoded depth, or its header gives only one dimension as zero or more
+// pixels than fit in an int32.
+SEURATCORE_API bool GetSeuratDepthSize(const uint8* Data, int64 DataSize, int32& OutWidth, int32& OutHeight);
+
+// Decodes depth encoded by EncodeSeuratDepth. Returns false if the data is
+// malformed or truncated.
+SEURATCORE_API bool DecodeSeuratDepth(const uint8* Data, int64 DataSize, TArray<float>& OutDepths, int32& OutWidth, int32& OutHeight);
@@ -0,0 +1,66 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Why a side of a sample is not captured.
+enum class ESeuratFaceCull : uint8
+{
+	None,
+	// The side sees too little geometry, e.g. only sky.
+	Empty,
+	// A nearby captured view of the same side already shows everything the
+	// side would, because its content is too distant to show parallax.
+	Redundant,
+};
+
+// Returns the name of |Cull| as recorded in the manifest.
+SEURATCORE_API const TCHAR* GetSeuratFaceCullName(ESeuratFaceCull Cull);
+
+// Depth coverage of a square face image.
+struct FSeuratFaceDepthStats
+{
+	// Fraction of the pixels nearer than the sky depth.
+	float GeometryFraction;
+	// Depth of the nearest pixel, or the sky depth if there is no geometry.
+	float MinDepth;
+
+	FSeuratFaceDepthStats() : GeometryFraction(0.0f), MinDepth(0.0f) {}
+};
+
+SEURATCORE_API FSeuratFaceDepthStats ComputeSeuratFaceDepthStats(const TArray<float>& Depths, float SkyDepth);
+
+struct FSeuratFaceCullSettings
+{
+	// Faces with less geometry than this fraction of their pixels are empty.
+	float MinGeometryFraction;
+	// Faces whose content moves by less than this many pixels of the captured
+	// resolution between the sample and a nearby captured sample are redundant.
+	float MaxParallaxPixels;
+	// Captured resolution of a face.
+	int32 Resolution;
+
+	FSeuratFaceCullSettings() : MinGeometryFraction(0.01f), MaxParallaxPixels(0.5f), Resolution(1024) {}
+};
+
+// Decides which sides of |Samples| to capture, from the depth statistics of
+// each side, |NumSides| per sample in sample order. The sides of the first
+// sample are always captured, as Seurat requires complete information at the
+// headbox center. Redundancy is tested against the captured sides of earlier
+// samples within parallax range, found in a uniform grid over the samples.
+SEURATCORE_API void CullSeuratFaces(const TArray<FVector>& Samples, int32 NumSides, const TArray<FSeuratFaceDepthStats>& FaceStats,
+	const FSeuratFaceCullSettings& Settings, TArray<ESeuratFaceCull>& OutCulls);
@@ -0,0 +1,64 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Low discrepancy sequences for headbox sampling. Points are reproducible: the
+// same index, dimension and seed always give the same value on every platform.
+enum class ESeuratSequence : uint8
+{
+	// Radical inverses in the first prime bases.
+	Halton,
+	Sobol,
+};
+
+// Reverses the order of the bits of |Bits|.
+SEURATCORE_API uint32 SeuratReverseBits(uint32 Bits);
+
+// Radical inverse base 2 of |Index|, by bit reversal.
+SEURATCORE_API float RadicalInverseBase2(uint32 Index);
+
+// Generates points of a low discrepancy sequence, optionally with Owen
+// scrambling. Scrambling randomizes the sequence by a seed while keeping its
+// stratification, which avoids the regular structure of the unscrambled
+// sequences in dense headboxes.
+class SEURATCORE_API FSeuratLowDiscrepancySequence
+{
+public:
+	static const int32 kMaxDimensions = 8;
+
+	FSeuratLowDiscrepancySequence(ESeuratSequence InSequence, int32 InNumDimensions, bool bInScramble = false, uint32 InSeed = 0);
+
+	int32 GetNumDimensions() const { return NumDimensions; }
+
+	// Returns component |Dimension| of point |Index|, in [0, 1).
+	float GetSample(uint32 Index, int32 Dimension) const;
+
+	// Generates points FirstIndex to FirstIndex + NumPoints - 1 into one array
+	// per dimension. Consecutive points are generated incrementally, which is
+	// considerably faster than calling GetSample for each.
+	void Generate(uint32 FirstIndex, int32 NumPoints, TArray<TArray<float>>& OutDimensions) const;
+
+private:
+	// Returns the sample as a 32 bit fixed point fraction.
+	uint32 GetSampleBits(uint32 Index, int32 Dimension) const;
+
+	ESeuratSequence Sequence;
+	int32 NumDimensions;
+	bool bScramble;
+	uint32 DimensionSeeds[kMaxDimensions];
+};
@@ -0,0 +1,31 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Convert a transformation matrix in Unreal coordinate system to Seurat's
+// coordinates.
+SEURATCORE_API FMatrix SeuratMatrixFromUnrealMatrix(FMatrix UnrealTransform);
+
+// Returns the Seurat clip-from-eye matrix of a 90 degree frustum with the given
+// near clip plane and infinite far plane.
+SEURATCORE_API FMatrix SeuratClipFromEyeMatrix(float NearClipPlane);
+
+// Returns the sample camera transform, in the actor convention of
+// SeuratMatrixFromUnrealMatrix, that a cube capture uses for the face with the
+// given ECubeFace index.
+SEURATCORE_API FMatrix CubeFaceWorldFromEye(int32 Face, FVector Position);
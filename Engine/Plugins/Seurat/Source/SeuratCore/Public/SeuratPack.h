@@ -0,0 +1,127 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+// Single file container for the images of a capture. Thousands of loose files
+// are slow to create on network file systems and to move around; a pack is
+// written sequentially and copied as one file.
+//
+// Layout, little endian:
+//   Header: char[4] "SPAK", uint32 version, uint32 settings hash,
+//     uint32 resume block, uint64 index offset, uint64 index size.
+//     The resume block is zero once the capture writing the pack completed.
+//     Otherwise payloads from that block of kSeuratPackPayloadAlignment
+//     bytes on were written by the incomplete capture.
+//   Records, 16 byte aligned, appended as files are written:
+//     char[4] "SPRC", uint32 name length, uint64 payload offset,
+//     uint64 payload size, UTF-8 name, zero padding, payload.
+//     Payloads are aligned to kSeuratPackPayloadAlignment, so they can be
+//     used in place from a memory mapped pack.
+//   Index, written when the pack is closed:
+//     char[4] "SPIX", uint32 entry count, then per entry uint64 payload
+//     offset, uint64 payload size, uint32 name offset, uint32 name length,
+//     then the UTF-8 names.
+//
+// A pack that was not closed has no index; its records are found by scanning.
+// A later record replaces an earlier one of the same name. Files of a completed
+// capture are only kept to update that capture, which renders again any view
+// the scene change may affect; an interrupted capture keeps its own files.
+
+#define SEURAT_PACK_EXTENSION TEXT("spak")
+
+static const int64 kSeuratPackPayloadAlignment = 4096;
+
+// Location of a file's contents in a pack.
+struct FSeuratPackEntry
+{
+	int64 Offset;
+	int64 Size;
+
+	FSeuratPackEntry() : Offset(0), Size(0) {}
+	FSeuratPackEntry(int64 InOffset, int64 InSize) : Offset(InOffset), Size(InSize) {}
+};
+
+// Appends files to a pack. Appending is thread safe.
+class SEURATCORE_API FSeuratPackWriter
+{
+public:
+	FSeuratPackWriter();
+	~FSeuratPackWriter();
+
+	// Opens a pack for appending. An existing pack made with the same settings
+	// is continued, keeping its complete records; otherwise it is replaced.
+	// Unless |bUpdate|, the pack of a completed capture is replaced too.
+	bool Open(const FString& InFilename, uint32 SettingsHash, bool bUpdate);
+	// Writes the index and closes the pack. Unless |bCaptureComplete|, the
+	// files written since the last completed capture are resumable when the
+	// pack is opened again.
+	bool Close(bool bCaptureComplete = false);
+
+	bool IsOpen() const { return Handle.IsValid(); }
+	const FString& GetFilename() const { return Filename; }
+
+	bool Append(const FString& Name, const uint8* Data, int64 Size, FSeuratPackEntry& OutEntry);
+	bool FindEntry(const FString& Name, FSeuratPackEntry& OutEntry) const;
+	// Whether the file was written by this capture or by the interrupted
+	// capture it resumes, rather than by an earlier completed capture.
+	bool IsResumable(const FString& Name) const;
+
+private:
+	bool WriteHeader(uint32 HeaderResumeBlock, uint64 IndexOffset, uint64 IndexSize);
+
+	FString Filename;
+	uint32 SettingsHash;
+	// First payload block written since the last completed capture.
+	uint32 ResumeBlock;
+	TUniquePtr<IFileHandle> Handle;
+	// End of the last complete record, where the next one starts.
+	int64 End;
+	TMap<FString, FSeuratPackEntry> Entries;
+	mutable FCriticalSection Lock;
+};
+
+// Reads files from a pack, either from disk by range or in place from memory.
+class SEURATCORE_API FSeuratPackReader
+{
+public:
+	FSeuratPackReader();
+	~FSeuratPackReader();
+
+	// Opens a pack on disk. Only the index is read; files are read on demand.
+	bool Open(const FString& Filename);
+	// Uses |InData|, e.g. a memory mapped pack, without copying it. The data
+	// must stay valid while the reader is used.
+	bool Initialize(const uint8* InData, int64 InDataSize);
+
+	uint32 GetSettingsHash() const { return SettingsHash; }
+	const TMap<FString, FSeuratPackEntry>& GetEntries() const { return Entries; }
+	const FSeuratPackEntry* FindEntry(const FString& Name) const { return Entries.Find(Name); }
+
+	// Reads a file of the pack. Not thread safe for packs opened from disk.
+	bool Read(const FSeuratPackEntry& Entry, TArray<uint8>& OutData) const;
+	// Returns the contents of a file of a pack in memory.
+	const uint8* GetPayload(const FSeuratPackEntry& Entry) const;
+
+private:
+	TUniquePtr<IFileHandle> Handle;
+	const uint8* Data;
+	uint32 SettingsHash;
+	TMap<FString, FSeuratPackEntry> Entries;
+};
@@ -0,0 +1,71 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Float16Color.h"
+
+// Usage statistics of a pixel buffer pool.
+struct FSeuratPixelBufferPoolStats
+{
+	// Buffers currently allocated, whether in use or pooled.
+	int32 NumAllocated;
+	int32 NumInUse;
+	int32 PeakInUse;
+	int64 PeakBytesInUse;
+	// Acquire calls, and how many of them had to allocate a new buffer.
+	int64 NumAcquires;
+	int64 NumAllocations;
+
+	FSeuratPixelBufferPoolStats() : NumAllocated(0), NumInUse(0), PeakInUse(0), PeakBytesInUse(0), NumAcquires(0), NumAllocations(0) {}
+};
+
+// Pool of fixed-size half float pixel buffers for capture images. Every view
+// of a capture has the same size, so buffers are recycled as whole
+// allocations instead of being allocated and freed per view, which avoids
+// fragmenting the heap with hundreds of megabytes per view. The pool may be
+// shared by the game thread and the image writer threads.
+class SEURATCORE_API FSeuratPixelBufferPool
+{
+public:
+	FSeuratPixelBufferPool();
+
+	// Sets the number of pixels per buffer. Pooled buffers of another size are
+	// freed, and so are buffers of another size when they are released.
+	void Configure(int32 InNumPixels);
+	int32 GetNumPixels() const;
+
+	// Returns a buffer of exactly the configured number of pixels, with
+	// undefined contents.
+	TArray<FFloat16Color> Acquire();
+	// Returns a buffer of |InNumPixels| pixels, first reconfiguring the pool if
+	// that is not the configured size. Captures with per-sample resolutions
+	// change size a few times per capture, not back and forth.
+	TArray<FFloat16Color> Acquire(int32 InNumPixels);
+	void Release(TArray<FFloat16Color>&& Buffer);
+	// Frees the pooled buffers that are not in use.
+	void Trim();
+
+	FSeuratPixelBufferPoolStats GetStats() const;
+	// Restarts peak and count statistics, e.g. at the start of a capture.
+	void ResetStats();
+
+private:
+	mutable FCriticalSection Lock;
+	int32 NumPixels;
+	TArray<TArray<FFloat16Color>> FreeBuffers;
+	FSeuratPixelBufferPoolStats Stats;
+};
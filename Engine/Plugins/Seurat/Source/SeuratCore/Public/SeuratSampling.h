@@ -0,0 +1,71 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Computes the radical inverse base |DigitBase| of the given value |A|.
+SEURATCORE_API float RadicalInverse(uint64 A, uint64 DigitBase);
+
+enum class ESeuratSamplePattern : uint8
+{
+	Hammersley,
+	Sobol,
+	// Owen scrambled Sobol, randomized by the sample seed.
+	ScrambledSobol,
+};
+
+// Generates |NumSamples| sample positions in a headbox of size |HeadboxSize|
+// centered on the origin of |HeadboxToWorld|, in world space. Samples are
+// sorted by distance from the headbox center, and the first sample is exactly
+// at the center because Seurat requires sampling information there.
+SEURATCORE_API void GenerateHeadboxSamples(int32 NumSamples, const FVector& HeadboxSize, const FTransform& HeadboxToWorld, TArray<FVector>& OutSamples,
+	ESeuratSamplePattern Pattern = ESeuratSamplePattern::Hammersley, uint32 Seed = 0);
+
+// Whether the headbox is a cube in world space. Distance relative to the size
+// of a cube orders samples like their world distance.
+SEURATCORE_API bool IsHeadboxCube(const FVector& HeadboxSize, const FTransform& HeadboxToWorld);
+
+// Number of headbox corners. Adaptive sampling measures the scene from each.
+static const int32 kNumHeadboxCorners = 8;
+
+// Returns corner |Corner| of the headbox in world space. Bits 0, 1 and 2 of
+// |Corner| select the positive X, Y and Z sides of the headbox.
+SEURATCORE_API FVector GetHeadboxCorner(int32 Corner, const FVector& HeadboxSize, const FTransform& HeadboxToWorld);
+
+// Estimates how much previously hidden scene a viewer sees when moving away
+// from where the |Width| by |Height| depth image |Depths| was rendered, from
+// the depth edges of the image. Depths below |MinDepth| count as |MinDepth|.
+SEURATCORE_API float EstimateDisocclusion(const TArray<float>& Depths, int32 Width, int32 Height, float MinDepth);
+
+// Generates samples like GenerateHeadboxSamples, from scrambled Sobol points
+// whose density varies trilinearly between |CornerWeights|, one weight per
+// headbox corner. Regions of the headbox with more disocclusion get
+// proportionally more samples.
+SEURATCORE_API void GenerateAdaptiveHeadboxSamples(int32 NumSamples, const FVector& HeadboxSize, const FTransform& HeadboxToWorld, const TArray<float>& CornerWeights, uint32 Seed, TArray<FVector>& OutSamples);
+
+// Returns how many times to halve the capture resolution of |Sample|. Samples
+// within |FalloffStart| of the headbox center, as a fraction of the distance
+// to a corner, keep full resolution; farther samples fall off linearly to
+// |MaxLevels| halvings at the corners.
+SEURATCORE_API int32 GetSampleResolutionLevel(const FVector& Sample, const FVector& HeadboxSize, const FTransform& HeadboxToWorld, float FalloffStart, int32 MaxLevels);
+
+// Reorders |Samples| after the first, which is at the center, by their distance
+// from the headbox center relative to the headbox size, as
+// GetSampleResolutionLevel measures it, so resolution never increases in
+// sample order. Samples keep their positions, but not their indices, in
+// headboxes that are not cubes.
+SEURATCORE_API void SortSamplesForResolutionFalloff(TArray<FVector>& Samples, const FVector& HeadboxSize, const FTransform& HeadboxToWorld);
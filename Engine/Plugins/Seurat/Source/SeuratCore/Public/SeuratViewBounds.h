@@ -0,0 +1,71 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Max depth of views whose farthest surface is not known, e.g. views that see
+// the sky.
+static const float kSeuratUnboundedDepth = MAX_flt;
+
+// Range of eye space depth of the surfaces captured in a view.
+struct FSeuratViewDepthRange
+{
+	float MinDepth;
+	float MaxDepth;
+
+	FSeuratViewDepthRange() : MinDepth(0.0f), MaxDepth(0.0f) {}
+	FSeuratViewDepthRange(float InMinDepth, float InMaxDepth) : MinDepth(InMinDepth), MaxDepth(InMaxDepth) {}
+
+	bool IsBounded() const { return MaxDepth < kSeuratUnboundedDepth; }
+};
+
+// Makes the depth range of a view from the depth read back from its image.
+// Read back depth is half precision, so sky and distant geometry read as the
+// largest half float or infinity rather than their distance. A view whose max
+// depth reaches |SkyDepth| or the range of half floats is unbounded.
+SEURATCORE_API FSeuratViewDepthRange MakeSeuratViewDepthRange(float MinDepth, float MaxDepth, float SkyDepth);
+
+// Whether any part of |Box| may be visible in a capture view. Views have a 90
+// degree square frustum starting at |NearClipPlane|, and |WorldFromEye| uses
+// Unreal's camera convention (X forward, Y right, Z up). Parts of the box
+// farther than |MaxDepth| are behind every captured surface, unless MaxDepth
+// is unbounded. The test is conservative: it may accept boxes that are not
+// actually visible.
+SEURATCORE_API bool SeuratViewMayShowBox(const FMatrix& WorldFromEye, float NearClipPlane, float MaxDepth, const FBox& Box);
+
+// Depth ranges of the views of a capture, keyed by image file name. Saved next
+// to the manifest, so a later capture can re-render only the views that a
+// scene change may affect.
+class SEURATCORE_API FSeuratViewBoundsFile
+{
+public:
+	FSeuratViewBoundsFile();
+
+	void Reset(uint32 InSettingsHash);
+	bool Load(const FString& Filename);
+	bool Save(const FString& Filename) const;
+
+	// Hash of the capture settings the views were captured with.
+	uint32 GetSettingsHash() const { return SettingsHash; }
+
+	void SetDepthRange(const FString& ImageName, const FSeuratViewDepthRange& DepthRange);
+	const FSeuratViewDepthRange* FindDepthRange(const FString& ImageName) const;
+
+private:
+	uint32 SettingsHash;
+	TMap<FString, FSeuratViewDepthRange> DepthRanges;
+};
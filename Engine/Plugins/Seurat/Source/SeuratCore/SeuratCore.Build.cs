@@ -0,0 +1,47 @@
+/* Copyright 2017 Google Inc.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*   http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+using UnrealBuildTool;
+
+public class SeuratCore : ModuleRules
+{
+	public SeuratCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		// Capture math, sampling, scheduling and manifest code that doesn't
+		// depend on the engine or editor, so it can be built and run on its own.
+		// Its automation tests, in Private/Tests, run without the editor too.
+		PublicIncludePaths.AddRange(
+			new string[] {
+				"SeuratCore/Public"
+			}
+			);
+
+
+		PrivateIncludePaths.AddRange(
+			new string[] {
+				"SeuratCore/Private",
+			}
+			);
+
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"Json",
+			}
+			);
+	}
+}